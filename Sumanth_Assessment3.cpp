@@ -3,6 +3,7 @@
 #include <vector>
 #include <queue>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <list>
 #include <ctime>
@@ -13,30 +14,577 @@
 #include <regex>
 #include <functional>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <cstdint>
+#include <random>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <deque>
+#include <limits>
+#include <cmath>
+#include <filesystem>
 
 using namespace std;
 
+// ------------------------- Allocation Statistics -------------------------
+// Process-wide heap counters, reported by the --bench mode so allocation
+// behaviour of the record store can be compared between implementations.
+// The global operator new/delete replacement that feeds them is only
+// compiled into benchmark builds (-DPFT_COUNT_ALLOCATIONS); otherwise the
+// counters stay at zero.
+struct AllocationStats {
+#ifdef PFT_COUNT_ALLOCATIONS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    static atomic<size_t> allocations;
+    static atomic<size_t> deallocations;
+    static atomic<size_t> bytes;
+
+    static void reset() {
+        allocations.store(0, memory_order_relaxed);
+        deallocations.store(0, memory_order_relaxed);
+        bytes.store(0, memory_order_relaxed);
+    }
+};
+
+atomic<size_t> AllocationStats::allocations{0};
+atomic<size_t> AllocationStats::deallocations{0};
+atomic<size_t> AllocationStats::bytes{0};
+
+#ifdef PFT_COUNT_ALLOCATIONS
+// Keeps GCC from pairing the inlined free() with the replaced operator new
+#if defined(__GNUC__)
+#define PFT_NOINLINE __attribute__((noinline))
+#else
+#define PFT_NOINLINE
+#endif
+
+void* operator new(size_t size) {
+    AllocationStats::allocations.fetch_add(1, memory_order_relaxed);
+    AllocationStats::bytes.fetch_add(size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+PFT_NOINLINE void operator delete(void* p) noexcept {
+    if (p) AllocationStats::deallocations.fetch_add(1, memory_order_relaxed);
+    free(p);
+}
+
+PFT_NOINLINE void operator delete(void* p, size_t) noexcept {
+    if (p) AllocationStats::deallocations.fetch_add(1, memory_order_relaxed);
+    free(p);
+}
+#endif // PFT_COUNT_ALLOCATIONS
+
+// ------------------------- Configuration -------------------------
+// Runtime settings come from the environment so deployments can tune them
+// without rebuilding.
+class Config {
+public:
+    static string get(const char* name, const string& fallback) {
+        const char* value = getenv(name);
+        return value && *value ? string(value) : fallback;
+    }
+    
+    static bool isSet(const char* name) {
+        const char* value = getenv(name);
+        return value && *value;
+    }
+};
+
+// ------------------------- Cryptographic Primitives -------------------------
+// Self-contained SHA-256 (FIPS 180-4), HMAC-SHA256 (RFC 2104), ChaCha20 and
+// Poly1305 (RFC 8439) so the tracker has no external crypto dependency.
+class Sha256 {
+private:
+    static constexpr uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+    
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t blockLen = 0;
+    uint64_t totalLen = 0;
+    
+    static uint32_t rotr(uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+    
+    void compress(const uint8_t* data) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+                   (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+    
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE = 64;
+    
+    Sha256() {
+        const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        memcpy(state, init, sizeof(state));
+    }
+    
+    void update(const void* data, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        totalLen += len;
+        if (blockLen > 0) {
+            size_t take = min(len, BLOCK_SIZE - blockLen);
+            memcpy(block + blockLen, p, take);
+            blockLen += take;
+            p += take;
+            len -= take;
+            if (blockLen < BLOCK_SIZE) return;
+            compress(block);
+            blockLen = 0;
+        }
+        while (len >= BLOCK_SIZE) {
+            compress(p);
+            p += BLOCK_SIZE;
+            len -= BLOCK_SIZE;
+        }
+        memcpy(block, p, len);
+        blockLen = len;
+    }
+    
+    void finish(uint8_t digest[DIGEST_SIZE]) {
+        uint64_t bitLen = totalLen * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (blockLen != 56) {
+            update(&pad, 1);
+        }
+        uint8_t lenBytes[8];
+        for (int i = 0; i < 8; i++) {
+            lenBytes[i] = uint8_t(bitLen >> (56 - i * 8));
+        }
+        update(lenBytes, 8);
+        for (int i = 0; i < 8; i++) {
+            digest[i * 4] = uint8_t(state[i] >> 24);
+            digest[i * 4 + 1] = uint8_t(state[i] >> 16);
+            digest[i * 4 + 2] = uint8_t(state[i] >> 8);
+            digest[i * 4 + 3] = uint8_t(state[i]);
+        }
+    }
+};
+
+class HmacSha256 {
+private:
+    Sha256 inner;
+    Sha256 outer;
+    
+public:
+    HmacSha256(const void* key, size_t keyLen) {
+        uint8_t keyBlock[Sha256::BLOCK_SIZE] = {0};
+        if (keyLen > Sha256::BLOCK_SIZE) {
+            Sha256 keyHash;
+            keyHash.update(key, keyLen);
+            keyHash.finish(keyBlock);
+        } else {
+            memcpy(keyBlock, key, keyLen);
+        }
+        
+        uint8_t pad[Sha256::BLOCK_SIZE];
+        for (size_t i = 0; i < Sha256::BLOCK_SIZE; i++) pad[i] = keyBlock[i] ^ 0x36;
+        inner.update(pad, sizeof(pad));
+        for (size_t i = 0; i < Sha256::BLOCK_SIZE; i++) pad[i] = keyBlock[i] ^ 0x5c;
+        outer.update(pad, sizeof(pad));
+    }
+    
+    void update(const void* data, size_t len) {
+        inner.update(data, len);
+    }
+    
+    void finish(uint8_t mac[Sha256::DIGEST_SIZE]) {
+        uint8_t innerDigest[Sha256::DIGEST_SIZE];
+        inner.finish(innerDigest);
+        outer.update(innerDigest, sizeof(innerDigest));
+        outer.finish(mac);
+    }
+};
+
+class ChaCha20 {
+private:
+    uint32_t input[16];
+    uint8_t keystream[64];
+    size_t keystreamPos = 64;
+    
+    static uint32_t rotl(uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+    
+    static uint32_t load32(const uint8_t* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+    
+    static void quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+        a += b; d = rotl(d ^ a, 16);
+        c += d; b = rotl(b ^ c, 12);
+        a += b; d = rotl(d ^ a, 8);
+        c += d; b = rotl(b ^ c, 7);
+    }
+    
+    void nextBlock() {
+        uint32_t x[16];
+        memcpy(x, input, sizeof(x));
+        for (int i = 0; i < 10; i++) {
+            quarterRound(x[0], x[4], x[8], x[12]);
+            quarterRound(x[1], x[5], x[9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[8], x[13]);
+            quarterRound(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; i++) {
+            uint32_t v = x[i] + input[i];
+            keystream[i * 4] = uint8_t(v);
+            keystream[i * 4 + 1] = uint8_t(v >> 8);
+            keystream[i * 4 + 2] = uint8_t(v >> 16);
+            keystream[i * 4 + 3] = uint8_t(v >> 24);
+        }
+        input[12]++;
+        keystreamPos = 0;
+    }
+    
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t NONCE_SIZE = 12;
+    
+    ChaCha20(const uint8_t key[KEY_SIZE], const uint8_t nonce[NONCE_SIZE], uint32_t counter = 1) {
+        input[0] = 0x61707865;
+        input[1] = 0x3320646e;
+        input[2] = 0x79622d32;
+        input[3] = 0x6b206574;
+        for (int i = 0; i < 8; i++) input[4 + i] = load32(key + i * 4);
+        input[12] = counter;
+        for (int i = 0; i < 3; i++) input[13 + i] = load32(nonce + i * 4);
+    }
+    
+    // XORs the keystream into data; successive calls continue the stream
+    void apply(uint8_t* data, size_t len) {
+        size_t i = 0;
+        while (i < len) {
+            if (keystreamPos == 64) {
+                nextBlock();
+            }
+            if (keystreamPos == 0) {
+                // Whole blocks straight from the fresh keystream
+                while (len - i >= 64) {
+                    for (size_t j = 0; j < 64; j += 8) {
+                        uint64_t word, key;
+                        memcpy(&word, data + i + j, 8);
+                        memcpy(&key, keystream + j, 8);
+                        word ^= key;
+                        memcpy(data + i + j, &word, 8);
+                    }
+                    i += 64;
+                    nextBlock();
+                }
+            }
+            while (i < len && keystreamPos < 64) {
+                data[i++] ^= keystream[keystreamPos++];
+            }
+        }
+    }
+};
+
+// 32-bit limb Poly1305 after poly1305-donna (public domain)
+class Poly1305 {
+private:
+    uint32_t r[5];
+    uint32_t h[5] = {0, 0, 0, 0, 0};
+    uint32_t pad[4];
+    uint8_t buffer[16];
+    size_t leftover = 0;
+    
+    static uint32_t load32(const uint8_t* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+    
+    void blocks(const uint8_t* m, size_t bytes, bool final) {
+        const uint32_t hibit = final ? 0 : (1U << 24);
+        const uint32_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+        const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+        uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+        
+        while (bytes >= 16) {
+            h0 += load32(m) & 0x3ffffff;
+            h1 += (load32(m + 3) >> 2) & 0x3ffffff;
+            h2 += (load32(m + 6) >> 4) & 0x3ffffff;
+            h3 += (load32(m + 9) >> 6) & 0x3ffffff;
+            h4 += (load32(m + 12) >> 8) | hibit;
+            
+            uint64_t d0 = uint64_t(h0) * r0 + uint64_t(h1) * s4 + uint64_t(h2) * s3 + uint64_t(h3) * s2 + uint64_t(h4) * s1;
+            uint64_t d1 = uint64_t(h0) * r1 + uint64_t(h1) * r0 + uint64_t(h2) * s4 + uint64_t(h3) * s3 + uint64_t(h4) * s2;
+            uint64_t d2 = uint64_t(h0) * r2 + uint64_t(h1) * r1 + uint64_t(h2) * r0 + uint64_t(h3) * s4 + uint64_t(h4) * s3;
+            uint64_t d3 = uint64_t(h0) * r3 + uint64_t(h1) * r2 + uint64_t(h2) * r1 + uint64_t(h3) * r0 + uint64_t(h4) * s4;
+            uint64_t d4 = uint64_t(h0) * r4 + uint64_t(h1) * r3 + uint64_t(h2) * r2 + uint64_t(h3) * r1 + uint64_t(h4) * r0;
+            
+            uint32_t c = uint32_t(d0 >> 26); h0 = uint32_t(d0) & 0x3ffffff;
+            d1 += c; c = uint32_t(d1 >> 26); h1 = uint32_t(d1) & 0x3ffffff;
+            d2 += c; c = uint32_t(d2 >> 26); h2 = uint32_t(d2) & 0x3ffffff;
+            d3 += c; c = uint32_t(d3 >> 26); h3 = uint32_t(d3) & 0x3ffffff;
+            d4 += c; c = uint32_t(d4 >> 26); h4 = uint32_t(d4) & 0x3ffffff;
+            h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+            h1 += c;
+            
+            m += 16;
+            bytes -= 16;
+        }
+        h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+    }
+    
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t TAG_SIZE = 16;
+    
+    explicit Poly1305(const uint8_t key[KEY_SIZE]) {
+        r[0] = load32(key) & 0x3ffffff;
+        r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+        r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+        r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+        r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+        for (int i = 0; i < 4; i++) pad[i] = load32(key + 16 + i * 4);
+    }
+    
+    void update(const void* data, size_t len) {
+        const uint8_t* m = static_cast<const uint8_t*>(data);
+        if (leftover) {
+            size_t take = min(len, 16 - leftover);
+            memcpy(buffer + leftover, m, take);
+            leftover += take;
+            m += take;
+            len -= take;
+            if (leftover < 16) return;
+            blocks(buffer, 16, false);
+            leftover = 0;
+        }
+        size_t whole = len & ~size_t(15);
+        if (whole) {
+            blocks(m, whole, false);
+            m += whole;
+            len -= whole;
+        }
+        memcpy(buffer, m, len);
+        leftover = len;
+    }
+    
+    // Zero padding up to the next 16-byte boundary, as the AEAD construction requires
+    void padToBlock() {
+        if (leftover) {
+            uint8_t zeros[16] = {0};
+            update(zeros, 16 - leftover);
+        }
+    }
+    
+    void finish(uint8_t mac[TAG_SIZE]) {
+        if (leftover) {
+            buffer[leftover++] = 1;
+            while (leftover < 16) buffer[leftover++] = 0;
+            blocks(buffer, 16, true);
+        }
+        
+        uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+        uint32_t c = h1 >> 26; h1 &= 0x3ffffff;
+        h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+        h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+        h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+        
+        // Compute h - p and keep it if it did not underflow
+        uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+        uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+        uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+        uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+        uint32_t g4 = h4 + c - (1U << 26);
+        uint32_t mask = (g4 >> 31) - 1;
+        g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+        mask = ~mask;
+        h0 = (h0 & mask) | g0;
+        h1 = (h1 & mask) | g1;
+        h2 = (h2 & mask) | g2;
+        h3 = (h3 & mask) | g3;
+        h4 = (h4 & mask) | g4;
+        
+        uint32_t words[4];
+        words[0] = h0 | (h1 << 26);
+        words[1] = (h1 >> 6) | (h2 << 20);
+        words[2] = (h2 >> 12) | (h3 << 14);
+        words[3] = (h3 >> 18) | (h4 << 8);
+        
+        uint64_t f = 0;
+        for (int i = 0; i < 4; i++) {
+            f = uint64_t(words[i]) + pad[i] + (f >> 32);
+            for (int j = 0; j < 4; j++) {
+                mac[i * 4 + j] = uint8_t(f >> (j * 8));
+            }
+        }
+    }
+};
+
 // ------------------------- Security Utilities -------------------------
 class SecurityUtils {
 public:
-    // Simple hash function for password hashing
-    static string hashPassword(const string& password) {
-        hash<string> hasher;
-        size_t hashValue = hasher(password);
-        return to_string(hashValue);
+    static constexpr const char* KDF_PREFIX = "pbkdf2-sha256";
+    static constexpr size_t SALT_SIZE = 16;
+    
+    // PBKDF2-HMAC-SHA256 (RFC 8018) producing one 32-byte block
+    static void pbkdf2(const string& password, const uint8_t* salt, size_t saltLen,
+                       unsigned int iterations, uint8_t out[Sha256::DIGEST_SIZE]) {
+        // Keying the HMAC once lets every iteration reuse the padded key states
+        HmacSha256 keyed(password.data(), password.size());
+        uint8_t u[Sha256::DIGEST_SIZE];
+        const uint8_t blockIndex[4] = {0, 0, 0, 1};
+        
+        HmacSha256 first = keyed;
+        first.update(salt, saltLen);
+        first.update(blockIndex, sizeof(blockIndex));
+        first.finish(u);
+        memcpy(out, u, sizeof(u));
+        
+        for (unsigned int i = 1; i < iterations; i++) {
+            HmacSha256 next = keyed;
+            next.update(u, sizeof(u));
+            next.finish(u);
+            for (size_t j = 0; j < sizeof(u); j++) {
+                out[j] ^= u[j];
+            }
+        }
+    }
+    
+    // Work factor for new hashes, tunable via FINANCE_TRACKER_KDF_ITERATIONS
+    static unsigned int kdfIterations() {
+        try {
+            unsigned long value = stoul(Config::get("FINANCE_TRACKER_KDF_ITERATIONS", "100000"));
+            return static_cast<unsigned int>(max(1000UL, min(value, 10000000UL)));
+        } catch (...) {
+            return 100000;
+        }
+    }
+    
+    // Salted hash stored as pbkdf2-sha256$<iterations>$<salt hex>$<hash hex>
+    static string hashPassword(const string& password, unsigned int iterations = kdfIterations()) {
+        uint8_t salt[SALT_SIZE];
+        uint8_t derived[Sha256::DIGEST_SIZE];
+        randomBytes(salt, sizeof(salt));
+        pbkdf2(password, salt, sizeof(salt), iterations, derived);
+        return string(KDF_PREFIX) + "$" + to_string(iterations) + "$" +
+               toHex(salt, sizeof(salt)) + "$" + toHex(derived, sizeof(derived));
+    }
+    
+    // Checks a password against a stored hash. needsUpgrade is set for legacy
+    // std::hash values and for hashes weaker than the configured cost.
+    static bool verifyPassword(const string& password, const string& stored, bool& needsUpgrade) {
+        needsUpgrade = false;
+        string prefix = string(KDF_PREFIX) + "$";
+        if (stored.compare(0, prefix.size(), prefix) != 0) {
+            needsUpgrade = true;
+            string legacy = to_string(hash<string>()(password));
+            return legacy.size() == stored.size() &&
+                   constantTimeEquals(reinterpret_cast<const uint8_t*>(legacy.data()),
+                                      reinterpret_cast<const uint8_t*>(stored.data()), legacy.size());
+        }
+        
+        size_t saltStart = stored.find('$', prefix.size());
+        size_t hashStart = saltStart == string::npos ? string::npos : stored.find('$', saltStart + 1);
+        if (hashStart == string::npos) return false;
+        
+        unsigned int iterations;
+        vector<uint8_t> salt, expected;
+        try {
+            iterations = static_cast<unsigned int>(stoul(stored.substr(prefix.size(), saltStart - prefix.size())));
+        } catch (...) {
+            return false;
+        }
+        if (iterations == 0 ||
+            !fromHex(stored.substr(saltStart + 1, hashStart - saltStart - 1), salt) ||
+            !fromHex(stored.substr(hashStart + 1), expected) ||
+            expected.size() != Sha256::DIGEST_SIZE) {
+            return false;
+        }
+        
+        uint8_t derived[Sha256::DIGEST_SIZE];
+        pbkdf2(password, salt.data(), salt.size(), iterations, derived);
+        needsUpgrade = iterations < kdfIterations();
+        return constantTimeEquals(derived, expected.data(), sizeof(derived));
     }
     
+    static string toHex(const uint8_t* data, size_t len) {
+        static const char digits[] = "0123456789abcdef";
+        string out(len * 2, '0');
+        for (size_t i = 0; i < len; i++) {
+            out[i * 2] = digits[data[i] >> 4];
+            out[i * 2 + 1] = digits[data[i] & 0x0f];
+        }
+        return out;
+    }
     
-    static string encryptData(const string& data, char key = 'S') {
-        string encrypted = data;
-        for (char& c : encrypted) {
-            c ^= key;
+    static bool fromHex(const string& hex, vector<uint8_t>& out) {
+        if (hex.size() % 2 != 0) return false;
+        out.resize(hex.size() / 2);
+        for (size_t i = 0; i < out.size(); i++) {
+            int hi = hexValue(hex[i * 2]), lo = hexValue(hex[i * 2 + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out[i] = uint8_t(hi << 4 | lo);
         }
-        return encrypted;
+        return true;
+    }
+    
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
     }
     
-    static string decryptData(const string& encryptedData, char key = 'S') {
-        return encryptData(encryptedData, key); 
+    // Legacy field obfuscation, only needed to read pre-segment data files
+    static void xorInPlace(char* data, size_t len, char key = 'S') {
+        for (size_t i = 0; i < len; i++) {
+            data[i] ^= key;
+        }
     }
     
     // Input validation
@@ -66,10 +614,403 @@ public:
         }
     }
     
+    static bool isValidAccountName(const string& name) {
+        if (name.empty() || name.length() > 32) {
+            return false;
+        }
+        return all_of(name.begin(), name.end(), [](char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-'; });
+    }
+    
+    // ISO 4217 style code: three upper-case letters
+    static bool isValidCurrency(const string& code) {
+        return code.size() == 3 && all_of(code.begin(), code.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+    }
+    
     static bool isValidTransactionType(const string& type) {
         vector<string> validTypes = {"income", "expense", "savings", "investment", "transfer"};
         return find(validTypes.begin(), validTypes.end(), type) != validTypes.end();
     }
+    
+    static bool constantTimeEquals(const uint8_t* a, const uint8_t* b, size_t len) {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < len; i++) {
+            diff |= a[i] ^ b[i];
+        }
+        return diff == 0;
+    }
+    
+    static void randomBytes(uint8_t* out, size_t len) {
+        random_device rd;
+        for (size_t i = 0; i < len; i += 4) {
+            unsigned int value = rd();
+            for (size_t j = 0; j < 4 && i + j < len; j++) {
+                out[i + j] = uint8_t(value >> (j * 8));
+            }
+        }
+    }
+};
+
+// ------------------------- Encrypted Segment Storage -------------------------
+// Data files are a sequence of self-contained segments:
+//   magic "PFTS" | kind | record version | reserved(2) | nonce(12)
+//   | payload length (8) | ciphertext | Poly1305 tag (16)
+// Payloads are sealed with ChaCha20-Poly1305 (RFC 8439) using the first 8
+// header bytes as associated data, and are encrypted in large chunks rather
+// than field by field.
+class SegmentCipher {
+public:
+    static constexpr uint32_t MAGIC = 0x53544650; // "PFTS"
+    static constexpr size_t TAG_SIZE = Poly1305::TAG_SIZE;
+    static constexpr size_t OVERHEAD = 8 + ChaCha20::NONCE_SIZE + sizeof(uint64_t) + TAG_SIZE;
+    
+    enum Kind : uint8_t {
+        RECORDS = 0,
+        TOMBSTONES = 1  // length-prefixed ids of records deleted since they were written
+    };
+    
+    // Streams one segment to a file; the payload length is patched in on
+    // finish, and readers treat a zero length followed by data at the end of
+    // the file as an interrupted append
+    class Writer {
+    private:
+        ostream& os;
+        ChaCha20 stream;
+        Poly1305 mac;
+        streampos lengthPos;
+        uint64_t payloadLen = 0;
+        
+    public:
+        Writer(const SegmentCipher& c, ostream& out, uint8_t kind, uint8_t recordVersion, const uint8_t* nonce)
+            : os(out), stream(c.key, nonce), mac(oneTimeKey(c.key, nonce).data()) {
+            uint8_t header[8] = {0};
+            memcpy(header, &MAGIC, sizeof(MAGIC));
+            header[4] = kind;
+            header[5] = recordVersion;
+            os.write(reinterpret_cast<const char*>(header), sizeof(header));
+            os.write(reinterpret_cast<const char*>(nonce), ChaCha20::NONCE_SIZE);
+            mac.update(header, sizeof(header));
+            mac.padToBlock();
+            lengthPos = os.tellp();
+            os.write(reinterpret_cast<const char*>(&payloadLen), sizeof(payloadLen));
+        }
+        
+        // Encrypts the chunk in place and appends it
+        void write(string& chunk) {
+            uint8_t* data = reinterpret_cast<uint8_t*>(&chunk[0]);
+            stream.apply(data, chunk.size());
+            mac.update(data, chunk.size());
+            os.write(chunk.data(), chunk.size());
+            payloadLen += chunk.size();
+        }
+        
+        bool finish() {
+            uint8_t tag[TAG_SIZE];
+            sealTag(mac, 8, payloadLen, tag);
+            os.write(reinterpret_cast<const char*>(tag), sizeof(tag));
+            streampos end = os.tellp();
+            os.seekp(lengthPos);
+            os.write(reinterpret_cast<const char*>(&payloadLen), sizeof(payloadLen));
+            os.seekp(end);
+            return os.good();
+        }
+    };
+    
+private:
+    uint8_t key[ChaCha20::KEY_SIZE];
+    
+    // Poly1305 key from ChaCha20 block 0, as in RFC 8439 section 2.6
+    static array<uint8_t, Poly1305::KEY_SIZE> oneTimeKey(const uint8_t* key, const uint8_t* nonce) {
+        array<uint8_t, Poly1305::KEY_SIZE> polyKey = {};
+        ChaCha20 block(key, nonce, 0);
+        block.apply(polyKey.data(), polyKey.size());
+        return polyKey;
+    }
+    
+    static void sealTag(Poly1305& mac, uint64_t aadLen, uint64_t payloadLen, uint8_t* tag) {
+        uint8_t lengths[16];
+        for (int i = 0; i < 8; i++) {
+            lengths[i] = uint8_t(aadLen >> (i * 8));
+            lengths[8 + i] = uint8_t(payloadLen >> (i * 8));
+        }
+        mac.padToBlock();
+        mac.update(lengths, sizeof(lengths));
+        mac.finish(tag);
+    }
+    
+public:
+    explicit SegmentCipher(const string& passphrase) {
+        const string label = "pft-segment-key";
+        HmacSha256 kdf(passphrase.data(), passphrase.size());
+        kdf.update(label.data(), label.size());
+        kdf.finish(key);
+    }
+    
+    // Key material comes from FINANCE_TRACKER_KEY; the built-in fallback only
+    // keeps existing installs working and offers no confidentiality.
+    static SegmentCipher fromConfig() {
+        return SegmentCipher(Config::get("FINANCE_TRACKER_KEY", "personal-finance-tracker"));
+    }
+    
+    // One-shot ChaCha20-Poly1305 encryption of data in place with arbitrary
+    // associated data; segments use the same construction with the header as AAD
+    static void seal(const uint8_t* key, const uint8_t* nonce, const uint8_t* aad, size_t aadLen,
+                     uint8_t* data, size_t len, uint8_t tag[TAG_SIZE]) {
+        Poly1305 mac(oneTimeKey(key, nonce).data());
+        mac.update(aad, aadLen);
+        mac.padToBlock();
+        ChaCha20 stream(key, nonce);
+        stream.apply(data, len);
+        mac.update(data, len);
+        sealTag(mac, aadLen, len, tag);
+    }
+    
+    static bool startsWithSegment(istream& is) {
+        uint32_t magic = 0;
+        streampos start = is.tellg();
+        is.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        bool found = is.gcount() == sizeof(magic) && magic == MAGIC;
+        is.clear();
+        is.seekg(start);
+        return found;
+    }
+    
+    Writer begin(ostream& os, uint8_t kind, uint8_t recordVersion) const {
+        uint8_t nonce[ChaCha20::NONCE_SIZE];
+        SecurityUtils::randomBytes(nonce, sizeof(nonce));
+        return Writer(*this, os, kind, recordVersion, nonce);
+    }
+    
+    // True if no segment header starts anywhere from `from` to the end of
+    // the stream, i.e. the bytes there are what an interrupted append leaves
+    // behind rather than a damaged segment followed by intact ones
+    static bool isTornTail(istream& is, streampos from) {
+        char magic[sizeof(MAGIC)];
+        memcpy(magic, &MAGIC, sizeof(MAGIC));
+        vector<char> buffer(1 << 16);
+        size_t carried = 0;
+        is.clear();
+        is.seekg(from);
+        while (is) {
+            is.read(buffer.data() + carried, buffer.size() - carried);
+            size_t filled = carried + static_cast<size_t>(is.gcount());
+            if (search(buffer.begin(), buffer.begin() + filled, magic, magic + sizeof(magic)) !=
+                buffer.begin() + filled) {
+                return false;
+            }
+            // Keep the last bytes in case a header straddles two reads
+            carried = min(filled, sizeof(magic) - 1);
+            copy(buffer.begin() + (filled - carried), buffer.begin() + filled, buffer.begin());
+        }
+        return true;
+    }
+    
+    // Reads, authenticates and decrypts the next segment into payload.
+    // Returns false only for a torn tail: a last segment cut short or left
+    // without its length by an interrupted append. Any other damage throws, so the intact segments
+    // after a bad one are never silently dropped.
+    bool readSegment(istream& is, uint8_t& kind, uint8_t& recordVersion, vector<char>& payload) const {
+        uint8_t header[8];
+        uint8_t nonce[ChaCha20::NONCE_SIZE];
+        uint64_t payloadLen;
+        streampos start = is.tellg();
+        is.read(reinterpret_cast<char*>(header), sizeof(header));
+        is.read(reinterpret_cast<char*>(nonce), sizeof(nonce));
+        is.read(reinterpret_cast<char*>(&payloadLen), sizeof(payloadLen));
+        if (!is.good()) {
+            if (is.eof() && isTornTail(is, start + streamoff(1))) return false;
+            throw runtime_error("Truncated segment header in the middle of the file");
+        }
+        if (memcmp(header, &MAGIC, sizeof(MAGIC)) != 0) {
+            throw runtime_error("Corrupted segment header");
+        }
+        
+        // A length running past the end is either a torn tail or corruption
+        streampos bodyStart = is.tellg();
+        is.seekg(0, ios::end);
+        uint64_t remaining = static_cast<uint64_t>(is.tellg() - bodyStart);
+        is.seekg(bodyStart);
+        if (payloadLen > remaining || remaining - payloadLen < TAG_SIZE) {
+            if (isTornTail(is, start + streamoff(1))) return false;
+            throw runtime_error("Corrupted segment length");
+        }
+        
+        payload.resize(payloadLen);
+        uint8_t storedTag[TAG_SIZE];
+        is.read(payload.data(), payloadLen);
+        is.read(reinterpret_cast<char*>(storedTag), sizeof(storedTag));
+        if (!is.good()) {
+            throw runtime_error("Failed reading transaction segment");
+        }
+        
+        uint8_t tag[TAG_SIZE];
+        Poly1305 mac(oneTimeKey(key, nonce).data());
+        mac.update(header, sizeof(header));
+        mac.padToBlock();
+        mac.update(payload.data(), payloadLen);
+        sealTag(mac, 8, payloadLen, tag);
+        if (!SecurityUtils::constantTimeEquals(tag, storedTag, TAG_SIZE)) {
+            // Writer patches the length in last, so an append interrupted
+            // before that leaves a zero length with the payload after it
+            if (payloadLen == 0 && is.peek() != EOF && isTornTail(is, start + streamoff(1))) return false;
+            throw runtime_error("Segment authentication failed (wrong FINANCE_TRACKER_KEY or corrupted file)");
+        }
+        
+        ChaCha20 stream(key, nonce);
+        stream.apply(reinterpret_cast<uint8_t*>(payload.data()), payloadLen);
+        kind = header[4];
+        recordVersion = header[5];
+        return true;
+    }
+};
+
+// Read-only istream view over a decrypted payload, avoiding a copy
+class MemoryStreamBuf : public streambuf {
+public:
+    MemoryStreamBuf(char* begin, size_t len) {
+        setg(begin, begin, begin + len);
+    }
+};
+
+// ------------------------- Date Utilities -------------------------
+// Calendar arithmetic on local-time day numbers (days since 1970-01-01).
+struct CivilDate {
+    int year;
+    int month;
+    int day;
+};
+
+class DateUtils {
+public:
+    static int daysFromCivil(int y, int m, int d) {
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const int yoe = y - era * 400;
+        const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+    
+    static CivilDate civilFromDays(int z) {
+        z += 719468;
+        const int era = (z >= 0 ? z : z - 146096) / 146097;
+        const int doe = z - era * 146097;
+        const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int mp = (5 * doy + 2) / 153;
+        const int d = doy - (153 * mp + 2) / 5 + 1;
+        const int m = mp + (mp < 10 ? 3 : -9);
+        return {yoe + era * 400 + (m <= 2), m, d};
+    }
+    
+    static int localDay(time_t t) {
+        tm local;
+#if defined(_WIN32)
+        localtime_s(&local, &t);
+#else
+        localtime_r(&t, &local);
+#endif
+        return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    }
+    
+    // Parses YYYY-MM-DD into a day number
+    static bool parseDate(const string& dateStr, int& dayNumber) {
+        int y, m, d;
+        char dash1, dash2;
+        istringstream ss(dateStr);
+        if (!(ss >> y >> dash1 >> m >> dash2 >> d) || dash1 != '-' || dash2 != '-') {
+            return false;
+        }
+        if (m < 1 || m > 12 || d < 1 || d > 31) {
+            return false;
+        }
+        dayNumber = daysFromCivil(y, m, d);
+        CivilDate check = civilFromDays(dayNumber);
+        return check.month == m && check.day == d;
+    }
+    
+    // Parses YYYY-MM-DD HH:MM:SS in local time
+    static bool parseDateTime(const string& text, time_t& out) {
+        tm parts = {};
+        char trailing;
+        if (sscanf(text.c_str(), "%d-%d-%d %d:%d:%d%c", &parts.tm_year, &parts.tm_mon, &parts.tm_mday,
+                   &parts.tm_hour, &parts.tm_min, &parts.tm_sec, &trailing) != 6) {
+            return false;
+        }
+        int day;
+        if (!parseDate(text.substr(0, text.find(' ')), day) ||
+            parts.tm_hour > 23 || parts.tm_min > 59 || parts.tm_sec > 60) {
+            return false;
+        }
+        parts.tm_year -= 1900;
+        parts.tm_mon -= 1;
+        parts.tm_isdst = -1;
+        out = mktime(&parts);
+        return out != static_cast<time_t>(-1);
+    }
+    
+    // Thread-safe "YYYY-MM-DD HH:MM:SS" in local time; returns the length written
+    static int formatDateTime(time_t t, char* buffer, size_t size) {
+        tm local;
+#if defined(_WIN32)
+        localtime_s(&local, &t);
+#else
+        localtime_r(&t, &local);
+#endif
+        return snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d:%02d",
+                        local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                        local.tm_hour, local.tm_min, local.tm_sec);
+    }
+    
+    // Local midnight at the start of a day number
+    static time_t startOfDay(int dayNumber) {
+        CivilDate c = civilFromDays(dayNumber);
+        tm parts = {};
+        parts.tm_year = c.year - 1900;
+        parts.tm_mon = c.month - 1;
+        parts.tm_mday = c.day;
+        parts.tm_isdst = -1;
+        return mktime(&parts);
+    }
+    
+    static string formatDay(int dayNumber) {
+        CivilDate c = civilFromDays(dayNumber);
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", c.year, c.month, c.day);
+        return buffer;
+    }
+};
+
+// ------------------------- CSV Utilities -------------------------
+class CsvUtils {
+public:
+    // Splits one line into fields, honouring double quotes and "" escapes
+    static bool splitLine(const string& line, vector<string>& fields) {
+        fields.clear();
+        string field;
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    i++;
+                } else if (c == '"') {
+                    quoted = false;
+                } else {
+                    field += c;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.push_back(move(field));
+                field.clear();
+            } else if (c != '\r') {
+                field += c;
+            }
+        }
+        fields.push_back(move(field));
+        return !quoted;
+    }
 };
 
 // ------------------------- User Management System -------------------------
@@ -144,25 +1085,110 @@ public:
     }
 };
 
-class UserManager {
+// Session tokens let repeated operations by an authenticated user skip the
+// password KDF, including from later processes: a token issued once can be
+// presented again until it expires after FINANCE_TRACKER_SESSION_TTL
+// seconds. Only SHA-256 digests of tokens are written to the session file,
+// so reading it does not yield usable tokens. An empty filename keeps
+// sessions in memory only.
+class SessionCache {
 private:
-    vector<User> users;
-    const string USER_FILE = "users.dat";
+    struct Session {
+        string username;
+        time_t expiresAt;
+    };
     
-public:
-    UserManager() {
-        loadUsers();
-        // Creating default admin if no users exist
-        if (users.empty()) {
-            createDefaultAdmin();
-        }
-    }
+    unordered_map<string, Session> sessions;  // keyed by token digest
+    time_t ttl;
+    string filename;
     
-    void createDefaultAdmin() {
-        User admin("Sumanth", "admin123", UserRole::ADMIN);
-        users.push_back(admin);
-        saveUsers();
-        cout << "Default admin created - Username: Sumanth, Password: admin123\n";
+    static string digestOf(const string& token) {
+        Sha256 sha;
+        sha.update(token.data(), token.size());
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        sha.finish(digest);
+        return SecurityUtils::toHex(digest, sizeof(digest));
+    }
+    
+    void load() {
+        ifstream ifs(filename);
+        string digest, username;
+        long long expiresAt;
+        time_t now = time(0);
+        while (ifs >> digest >> username >> expiresAt) {
+            if (expiresAt >= now) sessions[digest] = {username, static_cast<time_t>(expiresAt)};
+        }
+    }
+    
+    void save() const {
+        if (filename.empty()) return;
+        ofstream ofs(filename, ios::trunc);
+        for (const auto& [digest, session] : sessions) {
+            ofs << digest << ' ' << session.username << ' ' << static_cast<long long>(session.expiresAt) << '\n';
+        }
+        if (!ofs.good()) {
+            cerr << "Error saving sessions to " << filename << endl;
+        }
+    }
+    
+public:
+    explicit SessionCache(const string& file = "") : filename(file) {
+        try {
+            ttl = static_cast<time_t>(stol(Config::get("FINANCE_TRACKER_SESSION_TTL", "900")));
+        } catch (...) {
+            ttl = 900;
+        }
+        if (!filename.empty()) load();
+    }
+    
+    string issue(const string& username) {
+        uint8_t raw[32];
+        SecurityUtils::randomBytes(raw, sizeof(raw));
+        string token = SecurityUtils::toHex(raw, sizeof(raw));
+        sessions[digestOf(token)] = {username, time(0) + ttl};
+        save();
+        return token;
+    }
+    
+    bool validate(const string& token, string& username) {
+        auto it = sessions.find(digestOf(token));
+        if (it == sessions.end()) return false;
+        if (it->second.expiresAt < time(0)) {
+            sessions.erase(it);
+            save();
+            return false;
+        }
+        username = it->second.username;
+        return true;
+    }
+    
+    void revoke(const string& token) {
+        if (sessions.erase(digestOf(token))) save();
+    }
+};
+
+class UserManager {
+private:
+    vector<User> users;
+    SessionCache sessions{SESSION_FILE};
+    
+public:
+    static constexpr const char* USER_FILE = "users.dat";
+    static constexpr const char* SESSION_FILE = "sessions.dat";
+    
+    UserManager() {
+        loadUsers();
+        // Creating default admin if no users exist
+        if (users.empty()) {
+            createDefaultAdmin();
+        }
+    }
+    
+    void createDefaultAdmin() {
+        User admin("Sumanth", "admin123", UserRole::ADMIN);
+        users.push_back(admin);
+        saveUsers();
+        cout << "Default admin created - Username: Sumanth, Password: admin123\n";
     }
     
     bool registerUser(const string& username, const string& password, UserRole role = UserRole::STANDARD) {
@@ -197,20 +1223,52 @@ public:
     
     pair<bool, User> authenticate(const string& username, const string& password) {
         try {
-            string hashedInput = SecurityUtils::hashPassword(password);
+            auto it = find_if(users.begin(), users.end(),
+                              [&username](const User& u) { return u.username == username; });
+            if (it == users.end()) {
+                // Spend the same KDF time so unknown usernames are not distinguishable
+                SecurityUtils::hashPassword(password);
+                return {false, User()};
+            }
             
-            for (const auto& user : users) {
-                if (user.username == username && user.passwordHash == hashedInput) {
-                    return {true, user};
-                }
+            bool needsUpgrade = false;
+            if (!SecurityUtils::verifyPassword(password, it->passwordHash, needsUpgrade)) {
+                return {false, User()};
             }
-            return {false, User()};
+            
+            // Rehash legacy or under-cost hashes now that we know the password
+            if (needsUpgrade) {
+                it->passwordHash = SecurityUtils::hashPassword(password);
+                saveUsers();
+                cout << "Password hash upgraded for " << username << ".\n";
+            }
+            return {true, *it};
         } catch (const exception& e) {
             cerr << "Authentication error: " << e.what() << endl;
             return {false, User()};
         }
     }
     
+    string createSession(const User& user) {
+        return sessions.issue(user.username);
+    }
+    
+    pair<bool, User> authenticateSession(const string& token) {
+        string username;
+        if (sessions.validate(token, username)) {
+            for (const auto& user : users) {
+                if (user.username == username) {
+                    return {true, user};
+                }
+            }
+        }
+        return {false, User()};
+    }
+    
+    void endSession(const string& token) {
+        sessions.revoke(token);
+    }
+    
     void loadUsers() {
         try {
             ifstream ifs(USER_FILE, ios::binary);
@@ -256,29 +1314,142 @@ public:
     }
 };
 
+// ------------------------- Record Arena -------------------------
+// Bump allocator for the variable-length fields of transaction records.
+// Field bytes are copied once into large slabs and referenced through
+// string_view, so building a record costs no per-field heap allocations and
+// copying a Transaction is shallow. Memory is only returned by clear().
+class RecordArena {
+private:
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+    
+    vector<unique_ptr<char[]>> slabs;
+    unordered_set<string_view> interned;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    size_t bytesUsed = 0;
+    size_t bytesReserved = 0;
+    
+public:
+    RecordArena() = default;
+    RecordArena(const RecordArena&) = delete;
+    RecordArena& operator=(const RecordArena&) = delete;
+    
+    char* allocate(size_t len) {
+        if (len > remaining) {
+            size_t slabSize = max(SLAB_SIZE, len);
+            slabs.emplace_back(new char[slabSize]);
+            cursor = slabs.back().get();
+            remaining = slabSize;
+            bytesReserved += slabSize;
+        }
+        char* p = cursor;
+        cursor += len;
+        remaining -= len;
+        bytesUsed += len;
+        return p;
+    }
+    
+    string_view store(string_view value) {
+        if (value.empty()) return {};
+        char* p = allocate(value.size());
+        memcpy(p, value.data(), value.size());
+        return string_view(p, value.size());
+    }
+    
+    // Low-cardinality fields (type, category, username) share a single copy
+    string_view intern(string_view value) {
+        auto it = interned.find(value);
+        if (it != interned.end()) return *it;
+        string_view stored = store(value);
+        interned.insert(stored);
+        return stored;
+    }
+    
+    void clear() {
+        slabs.clear();
+        interned.clear();
+        cursor = nullptr;
+        remaining = 0;
+        bytesUsed = 0;
+        bytesReserved = 0;
+    }
+    
+    size_t slabCount() const { return slabs.size(); }
+    size_t usedBytes() const { return bytesUsed; }
+    size_t reservedBytes() const { return bytesReserved; }
+};
+
 // ------------------------- Enhanced Transaction Class -------------------------
+// String fields point into the owning TransactionManager's RecordArena.
 class Transaction {
 public:
-    string id;
-    string transactionType;
+    string_view id;
+    string_view transactionType;
     time_t date;
     float amount;
-    string description;
-    string category;
-    string username;
+    string_view description;
+    string_view category;
+    string_view username;
+    string_view currency;
+    string_view account;
+    string_view counterAccount;  // credited side of a transfer; empty otherwise
+    
+    static constexpr const char* DEFAULT_ACCOUNT = "main";
+    
+    static inline atomic<long long> idCounter{0};
+    
+    // Longest description and category readFromFile accepts. Writers refuse
+    // anything longer, since one unreadable record fails the whole store.
+    static constexpr size_t MAX_DESCRIPTION_LENGTH = 10000;
+    static constexpr size_t MAX_CATEGORY_LENGTH = 1000;
+    
+    static bool fitsStoredLimits(string_view desc, string_view cat) {
+        return desc.size() <= MAX_DESCRIPTION_LENGTH && cat.size() <= MAX_CATEGORY_LENGTH;
+    }
     
-    Transaction() : date(time(0)), amount(0.0) {
-        generateId();
+    Transaction() : date(time(0)), amount(0.0) {}
+    
+    // IDs are TXN<time>_<counter>. The counter continues above every ID
+    // already in the store (see reserveIdsAbove), so runs started within
+    // the same second never hand out the same ID.
+    void generateId(RecordArena& arena) {
+        long long counter = ++idCounter;
+        char buffer[48];
+        int len = snprintf(buffer, sizeof(buffer), "TXN%lld_%lld", static_cast<long long>(time(0)), counter);
+        id = arena.store(string_view(buffer, len));
+    }
+    
+    static void reserveIdsAbove(string_view existingId) {
+        size_t underscore = existingId.rfind('_');
+        if (underscore == string_view::npos) return;
+        long long counter = 0;
+        for (char c : existingId.substr(underscore + 1)) {
+            if (c < '0' || c > '9' || counter > numeric_limits<long long>::max() / 10 - 10) return;
+            counter = counter * 10 + (c - '0');
+        }
+        long long current = idCounter.load();
+        while (counter > current && !idCounter.compare_exchange_weak(current, counter)) {
+        }
     }
     
-    void generateId() {
-        static int counter = 0;
-        counter++;
-        id = "TXN" + to_string(time(0)) + "_" + to_string(counter);
+    void assign(RecordArena& arena, string_view type, time_t when, float value,
+                string_view desc, string_view cat, string_view user, string_view code,
+                string_view acct, string_view counter) {
+        transactionType = arena.intern(type);
+        date = when;
+        amount = value;
+        description = arena.store(desc);
+        category = arena.intern(cat);
+        username = arena.intern(user);
+        currency = arena.intern(code);
+        account = arena.intern(acct);
+        counterAccount = counter.empty() ? string_view() : arena.intern(counter);
+        generateId(arena);
     }
     
-    void input(const string& currentUser) {
-        string typeInput, amountStr;
+    void input(const string& currentUser, RecordArena& arena, const string& defaultCurrency) {
+        string typeInput, amountStr, descInput, categoryInput, currencyInput, accountInput, counterInput;
         
         cout << "Available types: income, expense, savings, investment, transfer\n";
         cout << "Enter transaction type: ";
@@ -287,7 +1458,6 @@ public:
         if (!SecurityUtils::isValidTransactionType(typeInput)) {
             throw invalid_argument("Invalid transaction type");
         }
-        transactionType = typeInput;
         
         cout << "Enter amount: ";
         cin >> amountStr;
@@ -295,192 +1465,2193 @@ public:
         if (!SecurityUtils::isValidAmount(amountStr)) {
             throw invalid_argument("Invalid amount");
         }
-        amount = stof(amountStr);
         
         cout << "Enter description: ";
         cin.ignore();
-        getline(cin, description);
+        getline(cin, descInput);
         
         cout << "Enter category: ";
-        getline(cin, category);
+        getline(cin, categoryInput);
+        
+        if (descInput.size() > MAX_DESCRIPTION_LENGTH) {
+            throw invalid_argument("Description longer than " + to_string(MAX_DESCRIPTION_LENGTH) + " characters");
+        }
+        if (categoryInput.size() > MAX_CATEGORY_LENGTH) {
+            throw invalid_argument("Category longer than " + to_string(MAX_CATEGORY_LENGTH) + " characters");
+        }
         
-        username = currentUser;
-        date = time(0);
-        generateId();
+        cout << "Enter currency (blank for " << defaultCurrency << "): ";
+        getline(cin, currencyInput);
+        if (currencyInput.empty()) currencyInput = defaultCurrency;
+        
+        if (!SecurityUtils::isValidCurrency(currencyInput)) {
+            throw invalid_argument("Invalid currency");
+        }
+        
+        cout << "Enter account (blank for " << DEFAULT_ACCOUNT << "): ";
+        getline(cin, accountInput);
+        if (accountInput.empty()) accountInput = DEFAULT_ACCOUNT;
+        
+        if (!SecurityUtils::isValidAccountName(accountInput)) {
+            throw invalid_argument("Invalid account name");
+        }
+        
+        if (typeInput == "transfer") {
+            cout << "Enter destination account: ";
+            getline(cin, counterInput);
+            if (!SecurityUtils::isValidAccountName(counterInput) || counterInput == accountInput) {
+                throw invalid_argument("Invalid destination account");
+            }
+        }
+        
+        assign(arena, typeInput, time(0), stof(amountStr), descInput, categoryInput, currentUser, currencyInput,
+               accountInput, counterInput);
     }
     
     void display() const {
         cout << "ID: " << id << "\n";
         cout << "Type: " << transactionType << "\n";
         cout << "Date: " << put_time(localtime(&date), "%Y-%m-%d %H:%M:%S") << "\n";
-        cout << "Amount: $" << fixed << setprecision(2) << amount << "\n";
+        cout << "Amount: " << fixed << setprecision(2) << amount << " " << currency << "\n";
         cout << "Description: " << description << "\n";
         cout << "Category: " << category << "\n";
         cout << "User: " << username << "\n";
+        cout << "Account: " << account;
+        if (!counterAccount.empty()) cout << " -> " << counterAccount;
+        cout << "\n";
         cout << "------------------------\n";
     }
     
-    bool writeToFile(ofstream& ofs) const {
+    // Records are written in plaintext; confidentiality comes from the
+    // enclosing encrypted segment
+    bool writeToFile(ostream& ofs) const {
         try {
-            // Encrypting sensitive data before writing
-            string encryptedDesc = SecurityUtils::encryptData(description);
-            string encryptedCategory = SecurityUtils::encryptData(category);
-            
-            // Writing ID
-            size_t len = id.length();
-            ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            ofs.write(id.c_str(), len);
-            
-            // Writing transaction type
-            len = transactionType.length();
-            ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            ofs.write(transactionType.c_str(), len);
+            for (string_view field : {id, transactionType}) {
+                size_t len = field.length();
+                ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+                ofs.write(field.data(), len);
+            }
             
             // Writing date and amount
             ofs.write(reinterpret_cast<const char*>(&date), sizeof(date));
             ofs.write(reinterpret_cast<const char*>(&amount), sizeof(amount));
             
-            // Writing encrypted description
-            len = encryptedDesc.length();
-            ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            ofs.write(encryptedDesc.c_str(), len);
+            for (string_view field : {description, category, username, currency, account, counterAccount}) {
+                size_t len = field.length();
+                ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+                ofs.write(field.data(), len);
+            }
+            
+            return ofs.good();
+        } catch (...) {
+            return false;
+        }
+    }
+    
+    // Bytes writeToFile produces for this record
+    size_t encodedSize() const {
+        return 8 * sizeof(size_t) + sizeof(date) + sizeof(amount) + id.size() + transactionType.size()
+             + description.size() + category.size() + username.size() + currency.size()
+             + account.size() + counterAccount.size();
+    }
+    
+    // recordVersion 1 predates currencies and 2 predates accounts, leaving
+    // those fields empty; legacyXor reads the original per-field XOR format,
+    // kept for migration
+    bool readFromFile(istream& ifs, RecordArena& arena, uint8_t recordVersion, bool legacyXor = false) {
+        try {
+            size_t len;
+            string scratch;
+            
+            // Reading ID
+            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!ifs.good() || len > 10000) return false;
+            char* idBytes = arena.allocate(len);
+            ifs.read(idBytes, len);
+            if (!ifs.good()) return false;
+            id = string_view(idBytes, len);
+            
+            // Reading transaction type
+            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!ifs.good() || len > 1000) return false;
+            scratch.resize(len);
+            ifs.read(&scratch[0], len);
+            if (!ifs.good()) return false;
+            transactionType = arena.intern(scratch);
+            
+            // Reading date and amount
+            ifs.read(reinterpret_cast<char*>(&date), sizeof(date));
+            if (!ifs.good()) return false;
+            ifs.read(reinterpret_cast<char*>(&amount), sizeof(amount));
+            if (!ifs.good()) return false;
+            
+            // Reading description straight into the arena
+            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!ifs.good() || len > MAX_DESCRIPTION_LENGTH) return false;
+            char* descBytes = arena.allocate(len);
+            ifs.read(descBytes, len);
+            if (!ifs.good()) return false;
+            if (legacyXor) SecurityUtils::xorInPlace(descBytes, len);
+            description = string_view(descBytes, len);
+            
+            // Reading category
+            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!ifs.good() || len > MAX_CATEGORY_LENGTH) return false;
+            scratch.resize(len);
+            ifs.read(&scratch[0], len);
+            if (!ifs.good()) return false;
+            if (legacyXor) SecurityUtils::xorInPlace(&scratch[0], len);
+            category = arena.intern(scratch);
+            
+            // Reading username
+            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if (!ifs.good() || len > 1000) return false;
+            scratch.resize(len);
+            ifs.read(&scratch[0], len);
+            if (!ifs.good()) return false;
+            username = arena.intern(scratch);
+            
+            // Reading currency
+            currency = string_view();
+            if (recordVersion >= 2) {
+                ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+                if (!ifs.good() || len > 16) return false;
+                scratch.resize(len);
+                ifs.read(&scratch[0], len);
+                if (!ifs.good()) return false;
+                currency = arena.intern(scratch);
+            }
+            
+            // Reading account and transfer counter account
+            account = counterAccount = string_view();
+            if (recordVersion >= 3) {
+                for (string_view* field : {&account, &counterAccount}) {
+                    ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+                    if (!ifs.good() || len > 1000) return false;
+                    scratch.resize(len);
+                    ifs.read(&scratch[0], len);
+                    if (!ifs.good()) return false;
+                    if (len > 0) *field = arena.intern(scratch);
+                }
+            }
+            
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+};
+
+// ------------------------- Time-Series Rollups -------------------------
+struct RollupCell {
+    double sum = 0.0;
+    long long count = 0;
+    
+    void merge(const RollupCell& other) {
+        sum += other.sum;
+        count += other.count;
+    }
+};
+
+// Pre-aggregated (user, type, category) series in day, month and year buckets,
+// summed in the base currency.
+// Range queries combine whole years and months with day buckets at the edges,
+// so a query touches at most a few dozen buckets regardless of history length.
+class RollupStore {
+public:
+    enum class Period : uint8_t {
+        DAY,
+        MONTH,
+        YEAR
+    };
+    
+private:
+    using SeriesKey = tuple<string, string, string>;
+    
+    struct Series {
+        map<int, RollupCell> buckets[3];
+    };
+    
+    map<SeriesKey, Series, less<>> series;
+    unsigned long long recordCount = 0;
+    unsigned long long idDigest = 0;
+    
+    static constexpr unsigned int FILE_MAGIC = 0x52544650; // "PFTR"
+    static constexpr unsigned int FILE_VERSION = 2;
+    
+    static int monthIndex(const CivilDate& c) {
+        return c.year * 12 + (c.month - 1);
+    }
+    
+    static int firstDayOfMonth(int index) {
+        int year = index >= 0 ? index / 12 : (index - 11) / 12;
+        return DateUtils::daysFromCivil(year, index - year * 12 + 1, 1);
+    }
+    
+    static int bucketOf(Period period, int day) {
+        if (period == Period::DAY) return day;
+        CivilDate c = DateUtils::civilFromDays(day);
+        return period == Period::MONTH ? monthIndex(c) : c.year;
+    }
+    
+    static void sumBuckets(const map<int, RollupCell>& buckets, int lo, int hi, RollupCell& out) {
+        if (lo > hi) return;
+        for (auto it = buckets.lower_bound(lo); it != buckets.end() && it->first <= hi; ++it) {
+            out.merge(it->second);
+        }
+    }
+    
+    static void sumMonthLevel(const Series& s, int from, int to, RollupCell& out) {
+        if (from > to) return;
+        CivilDate first = DateUtils::civilFromDays(from);
+        CivilDate last = DateUtils::civilFromDays(to);
+        int firstMonth = monthIndex(first) + (first.day == 1 ? 0 : 1);
+        int lastMonth = monthIndex(last) - (DateUtils::civilFromDays(to + 1).day == 1 ? 0 : 1);
+        
+        if (firstMonth > lastMonth) {
+            sumBuckets(s.buckets[static_cast<int>(Period::DAY)], from, to, out);
+            return;
+        }
+        sumBuckets(s.buckets[static_cast<int>(Period::DAY)], from, firstDayOfMonth(firstMonth) - 1, out);
+        sumBuckets(s.buckets[static_cast<int>(Period::MONTH)], firstMonth, lastMonth, out);
+        sumBuckets(s.buckets[static_cast<int>(Period::DAY)], firstDayOfMonth(lastMonth + 1), to, out);
+    }
+    
+    static void sumRange(const Series& s, int from, int to, RollupCell& out) {
+        if (from > to) return;
+        CivilDate first = DateUtils::civilFromDays(from);
+        CivilDate last = DateUtils::civilFromDays(to);
+        int firstYear = first.year + (first.month == 1 && first.day == 1 ? 0 : 1);
+        int lastYear = last.year - (last.month == 12 && last.day == 31 ? 0 : 1);
+        
+        if (firstYear > lastYear) {
+            sumMonthLevel(s, from, to, out);
+            return;
+        }
+        sumMonthLevel(s, from, DateUtils::daysFromCivil(firstYear, 1, 1) - 1, out);
+        sumBuckets(s.buckets[static_cast<int>(Period::YEAR)], firstYear, lastYear, out);
+        sumMonthLevel(s, DateUtils::daysFromCivil(lastYear + 1, 1, 1), to, out);
+    }
+    
+    void apply(const Transaction& t, double value, int sign) {
+        auto it = series.find(make_tuple(t.username, t.transactionType, t.category));
+        if (it == series.end()) {
+            it = series.emplace(SeriesKey(t.username, t.transactionType, t.category), Series()).first;
+        }
+        Series& s = it->second;
+        int day = DateUtils::localDay(t.date);
+        for (int p = 0; p < 3; p++) {
+            auto& buckets = s.buckets[p];
+            RollupCell& cell = buckets[bucketOf(static_cast<Period>(p), day)];
+            cell.sum += sign * value;
+            cell.count += sign;
+            if (cell.count == 0) {
+                buckets.erase(bucketOf(static_cast<Period>(p), day));
+            }
+        }
+        recordCount += sign;
+        idDigest ^= digestOf(t.id);
+    }
+    
+public:
+    // Order-independent fingerprint used to validate the persisted rollups
+    static unsigned long long digestOf(string_view id) {
+        unsigned long long h = 1469598103934665603ULL;
+        for (char c : id) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+    
+    // value is t's amount in the base currency
+    void add(const Transaction& t, double value) {
+        apply(t, value, 1);
+    }
+    
+    void remove(const Transaction& t, double value) {
+        apply(t, value, -1);
+    }
+    
+    void clear() {
+        series.clear();
+        recordCount = 0;
+        idDigest = 0;
+    }
+    
+    // Per-category totals of one user's transactions of a type over [fromDay, toDay]
+    map<string, RollupCell> totalsByCategory(const string& username, const string& type,
+                                             int fromDay, int toDay) const {
+        map<string, RollupCell> totals;
+        auto it = series.lower_bound(make_tuple(string_view(username), string_view(type), string_view()));
+        for (; it != series.end() && get<0>(it->first) == username && get<1>(it->first) == type; ++it) {
+            RollupCell cell;
+            sumRange(it->second, fromDay, toDay, cell);
+            if (cell.count > 0) {
+                totals[get<2>(it->first)] = cell;
+            }
+        }
+        return totals;
+    }
+    
+    // One category's totals per period bucket; edge buckets are clipped to the range
+    vector<pair<int, RollupCell>> periodSeries(const string& username, const string& type,
+                                               const string& category, Period period,
+                                               int fromDay, int toDay) const {
+        vector<pair<int, RollupCell>> result;
+        auto it = series.find(make_tuple(string_view(username), string_view(type), string_view(category)));
+        if (it == series.end() || fromDay > toDay) return result;
+        
+        int day = fromDay;
+        while (day <= toDay) {
+            int bucket = bucketOf(period, day);
+            int nextStart;
+            if (period == Period::DAY) nextStart = day + 1;
+            else if (period == Period::MONTH) nextStart = firstDayOfMonth(bucket + 1);
+            else nextStart = DateUtils::daysFromCivil(bucket + 1, 1, 1);
             
-            // Writing encrypted category
-            len = encryptedCategory.length();
-            ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            ofs.write(encryptedCategory.c_str(), len);
+            RollupCell cell;
+            sumRange(it->second, day, min(toDay, nextStart - 1), cell);
+            if (cell.count > 0) {
+                result.emplace_back(bucket, cell);
+            }
+            day = nextStart;
+        }
+        return result;
+    }
+    
+    // Totals of the period bucket containing day, for one series
+    RollupCell cellAt(string_view username, string_view type, string_view category, Period period, int day) const {
+        auto it = series.find(make_tuple(username, type, category));
+        if (it == series.end()) return RollupCell();
+        const auto& buckets = it->second.buckets[static_cast<int>(period)];
+        auto cell = buckets.find(bucketOf(period, day));
+        return cell != buckets.end() ? cell->second : RollupCell();
+    }
+    
+    static string bucketLabel(Period period, int bucket) {
+        if (period == Period::DAY) return DateUtils::formatDay(bucket);
+        if (period == Period::YEAR) return to_string(bucket);
+        return DateUtils::formatDay(firstDayOfMonth(bucket)).substr(0, 7);
+    }
+    
+    // ratesDigest identifies the exchange rates the sums were converted with
+    bool save(const string& filename, unsigned long long ratesDigest) const {
+        try {
+            ofstream ofs(filename, ios::binary | ios::trunc);
+            if (!ofs.is_open()) return false;
             
-            // Writing username
-            len = username.length();
-            ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-            ofs.write(username.c_str(), len);
+            ofs.write(reinterpret_cast<const char*>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+            ofs.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+            ofs.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
+            ofs.write(reinterpret_cast<const char*>(&idDigest), sizeof(idDigest));
+            ofs.write(reinterpret_cast<const char*>(&ratesDigest), sizeof(ratesDigest));
             
+            size_t count = series.size();
+            ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const auto& [key, s] : series) {
+                for (const string* field : {&get<0>(key), &get<1>(key), &get<2>(key)}) {
+                    size_t len = field->length();
+                    ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+                    ofs.write(field->c_str(), len);
+                }
+                for (const auto& buckets : s.buckets) {
+                    size_t n = buckets.size();
+                    ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+                    for (const auto& [bucket, cell] : buckets) {
+                        ofs.write(reinterpret_cast<const char*>(&bucket), sizeof(bucket));
+                        ofs.write(reinterpret_cast<const char*>(&cell.sum), sizeof(cell.sum));
+                        ofs.write(reinterpret_cast<const char*>(&cell.count), sizeof(cell.count));
+                    }
+                }
+            }
             return ofs.good();
         } catch (...) {
             return false;
         }
     }
     
-    bool readFromFile(ifstream& ifs) {
-        try {
-            size_t len;
-            
-            // Reading ID
-            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
-            if (!ifs.good() || len > 10000) return false;
-            id.resize(len);
-            ifs.read(&id[0], len);
-            if (!ifs.good()) return false;
-            
-            // Reading transaction type
-            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
-            if (!ifs.good() || len > 1000) return false;
-            transactionType.resize(len);
-            ifs.read(&transactionType[0], len);
-            if (!ifs.good()) return false;
-            
-            // Reading date and amount
-            ifs.read(reinterpret_cast<char*>(&date), sizeof(date));
-            if (!ifs.good()) return false;
-            ifs.read(reinterpret_cast<char*>(&amount), sizeof(amount));
-            if (!ifs.good()) return false;
-            
-            // Reading encrypted description
-            string encryptedDesc;
-            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
-            if (!ifs.good() || len > 10000) return false;
-            encryptedDesc.resize(len);
-            ifs.read(&encryptedDesc[0], len);
-            if (!ifs.good()) return false;
-            description = SecurityUtils::decryptData(encryptedDesc);
-            
-            // Reading encrypted category
-            string encryptedCategory;
-            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
-            if (!ifs.good() || len > 1000) return false;
-            encryptedCategory.resize(len);
-            ifs.read(&encryptedCategory[0], len);
-            if (!ifs.good()) return false;
-            category = SecurityUtils::decryptData(encryptedCategory);
-            
-            // Reading username
-            ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
-            if (!ifs.good() || len > 1000) return false;
-            username.resize(len);
-            ifs.read(&username[0], len);
-            
-            return ifs.good();
-        } catch (...) {
-            return false;
+    // Loads persisted rollups only if they describe exactly the given records
+    // converted with the given exchange rates
+    bool load(const string& filename, unsigned long long expectedCount, unsigned long long expectedDigest,
+              unsigned long long ratesDigest) {
+        try {
+            ifstream ifs(filename, ios::binary);
+            if (!ifs.is_open()) return false;
+            
+            unsigned int magic = 0, version = 0;
+            unsigned long long storedCount = 0, storedDigest = 0, storedRates = 0;
+            ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+            ifs.read(reinterpret_cast<char*>(&version), sizeof(version));
+            ifs.read(reinterpret_cast<char*>(&storedCount), sizeof(storedCount));
+            ifs.read(reinterpret_cast<char*>(&storedDigest), sizeof(storedDigest));
+            ifs.read(reinterpret_cast<char*>(&storedRates), sizeof(storedRates));
+            if (!ifs.good() || magic != FILE_MAGIC || version != FILE_VERSION ||
+                storedCount != expectedCount || storedDigest != expectedDigest || storedRates != ratesDigest) {
+                return false;
+            }
+            
+            map<SeriesKey, Series, less<>> loaded;
+            size_t count;
+            ifs.read(reinterpret_cast<char*>(&count), sizeof(count));
+            if (!ifs.good()) return false;
+            for (size_t i = 0; i < count; i++) {
+                string fields[3];
+                for (string& field : fields) {
+                    size_t len;
+                    ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+                    if (!ifs.good() || len > 10000) return false;
+                    field.resize(len);
+                    ifs.read(&field[0], len);
+                }
+                Series& s = loaded[SeriesKey(fields[0], fields[1], fields[2])];
+                for (auto& buckets : s.buckets) {
+                    size_t n;
+                    ifs.read(reinterpret_cast<char*>(&n), sizeof(n));
+                    if (!ifs.good()) return false;
+                    for (size_t j = 0; j < n; j++) {
+                        int bucket;
+                        RollupCell cell;
+                        ifs.read(reinterpret_cast<char*>(&bucket), sizeof(bucket));
+                        ifs.read(reinterpret_cast<char*>(&cell.sum), sizeof(cell.sum));
+                        ifs.read(reinterpret_cast<char*>(&cell.count), sizeof(cell.count));
+                        if (!ifs.good()) return false;
+                        buckets.emplace_hint(buckets.end(), bucket, cell);
+                    }
+                }
+            }
+            
+            series = move(loaded);
+            recordCount = storedCount;
+            idDigest = storedDigest;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+};
+
+// ------------------------- Budget and Anomaly Alerts -------------------------
+// Welford's running mean and variance; removal reverses an earlier add
+struct RunningStats {
+    long long count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    
+    void add(double x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+    
+    void remove(double x) {
+        if (count <= 1) {
+            *this = RunningStats();
+            return;
+        }
+        double previousMean = (count * mean - x) / (count - 1);
+        m2 = max(0.0, m2 - (x - previousMean) * (x - mean));
+        mean = previousMean;
+        count--;
+    }
+    
+    double stddev() const {
+        return count > 1 ? sqrt(m2 / (count - 1)) : 0.0;
+    }
+};
+
+struct AlertSettings {
+    double spikeSigma;
+    long long minHistory;
+    double warnFraction;
+    
+    // FINANCE_TRACKER_SPIKE_SIGMA / _SPIKE_MIN_HISTORY / _BUDGET_WARN
+    static AlertSettings fromConfig() {
+        AlertSettings settings{3.0, 10, 0.8};
+        try {
+            settings.spikeSigma = stod(Config::get("FINANCE_TRACKER_SPIKE_SIGMA", "3"));
+            settings.minHistory = max(2LL, stoll(Config::get("FINANCE_TRACKER_SPIKE_MIN_HISTORY", "10")));
+            settings.warnFraction = stod(Config::get("FINANCE_TRACKER_BUDGET_WARN", "0.8"));
+        } catch (...) {
+            cerr << "Invalid alert settings; using defaults.\n";
+            settings = {3.0, 10, 0.8};
+        }
+        return settings;
+    }
+};
+
+struct Alert {
+    string username;
+    string message;
+};
+
+// Monthly budgets and spending-spike detection for expenses, per
+// (user, category). Statistics are updated as records come and go, and
+// month-to-date totals come from the rollups, so evaluating an insert costs
+// a few lookups regardless of history length. Amounts and limits are in the
+// base currency. Only budgets are persisted;
+// the statistics are rebuilt with the indexes on load.
+class AlertEngine {
+private:
+    using StatsKey = pair<string_view, string_view>;
+    
+    struct StatsKeyHash {
+        size_t operator()(const StatsKey& key) const {
+            return hash<string_view>()(key.first) * 31 + hash<string_view>()(key.second);
+        }
+    };
+    
+    AlertSettings settings = AlertSettings::fromConfig();
+    map<tuple<string, string>, double, less<>> budgets;
+    // Keys point at interned arena strings of the owning TransactionManager
+    unordered_map<StatsKey, RunningStats, StatsKeyHash> stats;
+    
+    static constexpr unsigned int FILE_MAGIC = 0x42544650; // "PFTB"
+    static constexpr unsigned int FILE_VERSION = 1;
+    
+    static bool isSpending(const Transaction& t) {
+        return t.transactionType == "expense";
+    }
+    
+    static string money(double value) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "$%.2f", value);
+        return buffer;
+    }
+    
+public:
+    // Checks t, worth value in the base currency, against its category's
+    // history and budget. Call after the rollups include t and before observe.
+    void evaluate(const Transaction& t, double value, const RollupStore& rollups, vector<Alert>& raised) const {
+        if (!isSpending(t)) return;
+        
+        auto statsIt = stats.find(StatsKey(t.username, t.category));
+        if (statsIt != stats.end() && statsIt->second.count >= settings.minHistory) {
+            const RunningStats& history = statsIt->second;
+            double sigma = history.stddev();
+            if (sigma > 0 && value > history.mean + settings.spikeSigma * sigma) {
+                char detail[96];
+                snprintf(detail, sizeof(detail), "%.1f standard deviations above the ", (value - history.mean) / sigma);
+                raised.push_back({string(t.username), "Spending spike: " + string(t.id) + " " + money(value)
+                                  + " in " + string(t.category) + " is " + detail + money(history.mean) + " average"});
+            }
+        }
+        
+        auto budgetIt = budgets.find(make_tuple(t.username, t.category));
+        if (budgetIt == budgets.end()) return;
+        
+        int day = DateUtils::localDay(t.date);
+        double limit = budgetIt->second;
+        double after = rollups.cellAt(t.username, t.transactionType, t.category, RollupStore::Period::MONTH, day).sum;
+        double before = after - value;
+        string month = DateUtils::formatDay(day).substr(0, 7);
+        if (before <= limit && after > limit) {
+            raised.push_back({string(t.username), "Budget exceeded: " + string(t.category) + " spending for " + month
+                              + " is " + money(after) + " of " + money(limit)});
+        } else if (before < limit * settings.warnFraction && after >= limit * settings.warnFraction && after <= limit) {
+            raised.push_back({string(t.username), "Budget warning: " + string(t.category) + " spending for " + month
+                              + " is " + money(after) + " of " + money(limit)});
+        }
+    }
+    
+    void observe(const Transaction& t, double value) {
+        if (isSpending(t)) stats[StatsKey(t.username, t.category)].add(value);
+    }
+    
+    void forget(const Transaction& t, double value) {
+        if (!isSpending(t)) return;
+        auto it = stats.find(StatsKey(t.username, t.category));
+        if (it == stats.end()) return;
+        it->second.remove(value);
+        if (it->second.count == 0) stats.erase(it);
+    }
+    
+    void clearStats() {
+        stats.clear();
+    }
+    
+    const RunningStats* statsFor(string_view username, string_view category) const {
+        auto it = stats.find(StatsKey(username, category));
+        return it != stats.end() ? &it->second : nullptr;
+    }
+    
+    // A non-positive limit removes the budget
+    void setBudget(const string& username, const string& category, double limit) {
+        if (limit > 0) budgets[make_tuple(username, category)] = limit;
+        else budgets.erase(make_tuple(username, category));
+    }
+    
+    // (category, monthly limit) pairs for one user
+    vector<pair<string, double>> budgetsFor(const string& username) const {
+        vector<pair<string, double>> result;
+        auto it = budgets.lower_bound(make_tuple(string_view(username), string_view()));
+        for (; it != budgets.end() && get<0>(it->first) == username; ++it) {
+            result.emplace_back(get<1>(it->first), it->second);
+        }
+        return result;
+    }
+    
+    bool save(const string& filename) const {
+        try {
+            ofstream ofs(filename, ios::binary | ios::trunc);
+            if (!ofs.is_open()) return false;
+            
+            ofs.write(reinterpret_cast<const char*>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+            ofs.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+            size_t count = budgets.size();
+            ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const auto& [key, limit] : budgets) {
+                for (const string* field : {&get<0>(key), &get<1>(key)}) {
+                    size_t len = field->length();
+                    ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+                    ofs.write(field->c_str(), len);
+                }
+                ofs.write(reinterpret_cast<const char*>(&limit), sizeof(limit));
+            }
+            return ofs.good();
+        } catch (...) {
+            return false;
+        }
+    }
+    
+    bool load(const string& filename) {
+        try {
+            ifstream ifs(filename, ios::binary);
+            if (!ifs.is_open()) return false;
+            
+            unsigned int magic = 0, version = 0;
+            size_t count = 0;
+            ifs.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+            ifs.read(reinterpret_cast<char*>(&version), sizeof(version));
+            ifs.read(reinterpret_cast<char*>(&count), sizeof(count));
+            if (!ifs.good() || magic != FILE_MAGIC || version != FILE_VERSION) {
+                return false;
+            }
+            
+            map<tuple<string, string>, double, less<>> loaded;
+            for (size_t i = 0; i < count; i++) {
+                string fields[2];
+                for (string& field : fields) {
+                    size_t len;
+                    ifs.read(reinterpret_cast<char*>(&len), sizeof(len));
+                    if (!ifs.good() || len > 10000) return false;
+                    field.resize(len);
+                    ifs.read(&field[0], len);
+                }
+                double limit;
+                ifs.read(reinterpret_cast<char*>(&limit), sizeof(limit));
+                if (!ifs.good()) return false;
+                loaded[make_tuple(fields[0], fields[1])] = limit;
+            }
+            budgets = move(loaded);
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+};
+
+// ------------------------- Exchange Rates -------------------------
+// Dated rates into the base currency (FINANCE_TRACKER_BASE_CURRENCY, default
+// USD), read from a CSV of date,currency,rate lines where rate is the base
+// value of one unit. A rate holds from its date until the currency's next
+// one; days before a currency's first rate use that first rate. Days are
+// local calendar days, as in the rollups. Rate dates must fall in 1970-2099
+// so one stray row cannot blow up the table.
+//
+// All rates are expanded into one dense (currency, day) table, so converting
+// a row is an index computation and a multiply with no lookups or branches.
+// The base currency's row is all ones and unknown currencies share a row of
+// NaNs, which callers count as unconverted.
+class ExchangeRates {
+private:
+    string base;
+    vector<string> codes;  // id -> code; 0 is the base, codes.size() is "unknown"
+    map<string, uint16_t, less<>> ids;
+    int firstDay = 0;
+    int span = 1;
+    vector<double> table;
+    unsigned long long fingerprint = 0;
+    
+public:
+    using DatedRates = map<string, map<int, double>>;
+    
+    explicit ExchangeRates(const string& baseCurrency) : base(baseCurrency) {
+        setRates(DatedRates());
+    }
+    
+    static ExchangeRates fromConfig() {
+        return ExchangeRates(Config::get("FINANCE_TRACKER_BASE_CURRENCY", "USD"));
+    }
+    
+    const string& baseCurrency() const {
+        return base;
+    }
+    
+    // Changes whenever the table would convert differently
+    unsigned long long digest() const {
+        return fingerprint;
+    }
+    
+    uint16_t unknownId() const {
+        return static_cast<uint16_t>(codes.size());
+    }
+    
+    uint16_t idOf(string_view code) const {
+        auto it = ids.find(code);
+        return it != ids.end() ? it->second : unknownId();
+    }
+    
+    static bool inRateWindow(int day) {
+        return day >= 0 && day < DateUtils::daysFromCivil(2100, 1, 1);
+    }
+    
+    void setRates(const DatedRates& dated) {
+        codes.assign(1, base);
+        ids.clear();
+        ids[base] = 0;
+        int lastDay = 0;
+        bool any = false;
+        for (const auto& [code, byDay] : dated) {
+            if (code == base || byDay.empty()) continue;
+            ids[code] = static_cast<uint16_t>(codes.size());
+            codes.push_back(code);
+            firstDay = any ? min(firstDay, byDay.begin()->first) : byDay.begin()->first;
+            lastDay = any ? max(lastDay, byDay.rbegin()->first) : byDay.rbegin()->first;
+            any = true;
+        }
+        span = any ? lastDay - firstDay + 1 : 1;
+        if (!any) firstDay = 0;
+        
+        table.assign((codes.size() + 1) * span, 1.0);
+        fill(table.end() - span, table.end(), numeric_limits<double>::quiet_NaN());
+        fingerprint = RollupStore::digestOf(base);
+        for (size_t id = 1; id < codes.size(); id++) {
+            const auto& byDay = dated.at(codes[id]);
+            double* row = &table[id * span];
+            auto next = byDay.begin();
+            double rate = next->second;
+            for (int d = 0; d < span; d++) {
+                while (next != byDay.end() && next->first <= firstDay + d) {
+                    rate = next->second;
+                    ++next;
+                }
+                row[d] = rate;
+            }
+            for (const auto& [day, value] : byDay) {
+                unsigned long long bits;
+                memcpy(&bits, &value, sizeof(bits));
+                fingerprint ^= RollupStore::digestOf(codes[id] + to_string(day)) * 31 + bits;
+            }
+        }
+    }
+    
+    // Reads date,currency,rate lines; a missing file leaves only the base currency
+    bool load(const string& path) {
+        ifstream in(path);
+        if (!in.is_open()) return false;
+        
+        DatedRates dated;
+        string line;
+        vector<string> fields;
+        int lineNumber = 0, day;
+        while (getline(in, line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#' || line.compare(0, 4, "Date") == 0) continue;
+            try {
+                if (!CsvUtils::splitLine(line, fields) || fields.size() < 3 ||
+                    !DateUtils::parseDate(fields[0], day) || !inRateWindow(day) ||
+                    !SecurityUtils::isValidCurrency(fields[1])) {
+                    throw invalid_argument("bad field");
+                }
+                double rate = stod(fields[2]);
+                if (!(rate > 0)) throw invalid_argument("bad rate");
+                dated[fields[1]][day] = rate;
+            } catch (const exception&) {
+                cerr << "Ignoring invalid exchange rate on line " << lineNumber << " of " << path << endl;
+            }
+        }
+        setRates(dated);
+        return true;
+    }
+    
+    double rate(uint16_t id, int day) const {
+        return table[id * span + min(max(day - firstDay, 0), span - 1)];
+    }
+    
+    double convert(string_view code, time_t date, double amount) const {
+        return amount * rate(idOf(code), DateUtils::localDay(date));
+    }
+    
+    // out[i] = amounts[i] in the base currency; NaN for unknown currencies
+    void convertBatch(const uint16_t* currencyIds, const int* days, const float* amounts,
+                      double* out, size_t n) const {
+        const double* rates = table.data();
+        for (size_t i = 0; i < n; i++) {
+            int offset = min(max(days[i] - firstDay, 0), span - 1);
+            out[i] = amounts[i] * rates[currencyIds[i] * span + offset];
+        }
+    }
+    
+    // Memoizes idOf for interned currency strings, which compare by address
+    class IdCache {
+    private:
+        const ExchangeRates& rates;
+        array<pair<const char*, uint16_t>, 8> slots;
+        size_t used = 0;
+        
+    public:
+        explicit IdCache(const ExchangeRates& r) : rates(r) {}
+        
+        uint16_t operator()(string_view code) {
+            for (size_t i = 0; i < used; i++) {
+                if (slots[i].first == code.data()) return slots[i].second;
+            }
+            uint16_t id = rates.idOf(code);
+            if (used < slots.size()) slots[used++] = {code.data(), id};
+            return id;
+        }
+    };
+};
+
+// ------------------------- Account Balances -------------------------
+// Running totals by local day for one account: a Fenwick tree over a window
+// of days that doubles whenever a posting falls outside it. Posting and
+// balance-as-of-a-day are O(log D) in the days the window covers.
+class DayFenwick {
+private:
+    int origin = 0;
+    vector<double> tree = vector<double>(1);  // 1-based; tree[0] unused
+    
+    size_t window() const {
+        return tree.size() - 1;
+    }
+    
+    // Regrows the window to cover day, carrying over the per-day values.
+    // Linear in the new window size; happens O(log D) times in total.
+    void cover(int day) {
+        size_t n = window();
+        if (n > 0 && day >= origin && static_cast<size_t>(day - origin) < n) return;
+        
+        for (size_t i = n; i > 0; i--) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= n) tree[parent] -= tree[i];
+        }
+        int lo = n > 0 ? min(origin, day) : day;
+        int hi = n > 0 ? max(origin + static_cast<int>(n) - 1, day) : day;
+        size_t size = max<size_t>(64, n);
+        while (size < static_cast<size_t>(hi - lo + 1)) size *= 2;
+        
+        // Leave the slack on the side the window grew towards
+        int newOrigin = n > 0 && day < origin ? hi - static_cast<int>(size) + 1 : lo;
+        vector<double> grown(size + 1, 0.0);
+        for (size_t i = 1; i <= n; i++) {
+            grown[origin - newOrigin + i] = tree[i];
+        }
+        for (size_t i = 1; i <= size; i++) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= size) grown[parent] += grown[i];
+        }
+        tree = move(grown);
+        origin = newOrigin;
+    }
+    
+public:
+    void add(int day, double delta) {
+        cover(day);
+        for (size_t i = day - origin + 1; i <= window(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+    
+    // Sum of everything posted on or before day
+    double prefix(int day) const {
+        if (window() == 0 || day < origin) return 0.0;
+        double sum = 0.0;
+        for (size_t i = min<size_t>(day - origin + 1, window()); i > 0; i -= i & (~i + 1)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+};
+
+// Double-entry postings per (user, account), in the base currency. Income,
+// savings and investments credit the record's account and expenses debit
+// it; a transfer debits its account and credits the counter account, so
+// transfers never change a user's total. Transfers recorded before accounts
+// existed have no counter account and post nothing. Rebuilt with the indexes
+// on load rather than persisted.
+class AccountBalances {
+private:
+    map<tuple<string, string>, DayFenwick, less<>> accounts;
+    
+    DayFenwick& ledgerOf(string_view username, string_view account) {
+        auto it = accounts.find(make_tuple(username, account));
+        if (it == accounts.end()) {
+            it = accounts.emplace(make_tuple(string(username), string(account)), DayFenwick()).first;
+        }
+        return it->second;
+    }
+    
+    void post(const Transaction& t, double value) {
+        int day = DateUtils::localDay(t.date);
+        if (t.transactionType == "transfer") {
+            if (t.counterAccount.empty()) return;
+            ledgerOf(t.username, t.account).add(day, -value);
+            ledgerOf(t.username, t.counterAccount).add(day, value);
+        } else {
+            ledgerOf(t.username, t.account).add(day, t.transactionType == "expense" ? -value : value);
+        }
+    }
+    
+public:
+    // value is t's amount in the base currency
+    void add(const Transaction& t, double value) {
+        post(t, value);
+    }
+    
+    void remove(const Transaction& t, double value) {
+        post(t, -value);
+    }
+    
+    void clear() {
+        accounts.clear();
+    }
+    
+    // Balance at the end of day
+    double balance(const string& username, const string& account, int day) const {
+        auto it = accounts.find(make_tuple(string_view(username), string_view(account)));
+        return it != accounts.end() ? it->second.prefix(day) : 0.0;
+    }
+    
+    // (account, balance at the end of day) for each of one user's accounts
+    vector<pair<string, double>> balancesFor(const string& username, int day) const {
+        vector<pair<string, double>> result;
+        auto it = accounts.lower_bound(make_tuple(string_view(username), string_view()));
+        for (; it != accounts.end() && get<0>(it->first) == username; ++it) {
+            result.emplace_back(get<1>(it->first), it->second.prefix(day));
+        }
+        return result;
+    }
+};
+
+// ------------------------- Ingestion Pipeline -------------------------
+// A pre-validated record queued by a producer. Fields are owned here because
+// producers never touch the single-threaded record arena.
+struct IngestRecord {
+    string type;
+    time_t date = 0;
+    float amount = 0.0f;
+    string description;
+    string category;
+    string username;
+    string currency;  // empty means the base currency
+    string account;   // empty means the default account
+    string counterAccount;
+};
+
+// Bounded lock-free multi-producer / single-consumer ring buffer (Vyukov).
+// Each cell's sequence number says whose turn it is: producers claim a slot
+// with one CAS on the enqueue position, the consumer never contends.
+template <typename T>
+class MpscRingBuffer {
+private:
+    struct Cell {
+        atomic<size_t> sequence;
+        T value;
+    };
+    
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos{0};
+    alignas(64) size_t dequeuePos = 0;
+    
+public:
+    explicit MpscRingBuffer(size_t requested) {
+        size_t capacity = 2;
+        while (capacity < requested) capacity <<= 1;
+        cells.reset(new Cell[capacity]);
+        mask = capacity - 1;
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+    
+    // Fails without consuming the value when the ring is full
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        cell->value = move(value);
+        cell->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+    
+    // Single consumer only
+    bool tryPop(T& out) {
+        Cell& cell = cells[dequeuePos & mask];
+        size_t seq = cell.sequence.load(memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(dequeuePos + 1) < 0) {
+            return false;
+        }
+        out = move(cell.value);
+        cell.sequence.store(dequeuePos + mask + 1, memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+    
+    size_t capacity() const {
+        return mask + 1;
+    }
+};
+
+struct IngestionSettings {
+    size_t capacity;
+    size_t maxBatch;
+    chrono::milliseconds maxLatency;
+    
+    // FINANCE_TRACKER_INGEST_CAPACITY / _BATCH / _LATENCY_MS
+    static IngestionSettings fromConfig() {
+        IngestionSettings settings{65536, 4096, chrono::milliseconds(20)};
+        try {
+            settings.capacity = stoul(Config::get("FINANCE_TRACKER_INGEST_CAPACITY", "65536"));
+            settings.maxBatch = max<size_t>(1, stoul(Config::get("FINANCE_TRACKER_INGEST_BATCH", "4096")));
+            settings.maxLatency = chrono::milliseconds(stol(Config::get("FINANCE_TRACKER_INGEST_LATENCY_MS", "20")));
+        } catch (...) {
+            cerr << "Invalid ingestion settings; using defaults.\n";
+            settings = {65536, 4096, chrono::milliseconds(20)};
+        }
+        return settings;
+    }
+};
+
+// Producers submit records from any thread; one consumer thread drains the
+// ring and hands batches to the sink once maxBatch records are waiting or the
+// oldest one has waited maxLatency.
+class IngestionPipeline {
+public:
+    using BatchSink = function<void(vector<IngestRecord>&)>;
+    
+private:
+    IngestionSettings settings;
+    MpscRingBuffer<IngestRecord> queue;
+    BatchSink sink;
+    atomic<bool> stopping{false};
+    thread consumer;
+    chrono::steady_clock::time_point startedAt;
+    chrono::steady_clock::time_point stoppedAt;
+    
+    atomic<size_t> submitted{0};
+    atomic<size_t> rejected{0};
+    atomic<size_t> backpressureWaits{0};
+    size_t applied = 0;
+    size_t batches = 0;
+    size_t largestBatch = 0;
+    
+    void flush(vector<IngestRecord>& batch) {
+        sink(batch);
+        applied += batch.size();
+        batches++;
+        largestBatch = max(largestBatch, batch.size());
+        batch.clear();
+    }
+    
+    void consumeLoop() {
+        vector<IngestRecord> batch;
+        batch.reserve(settings.maxBatch);
+        IngestRecord record;
+        chrono::steady_clock::time_point deadline;
+        
+        for (;;) {
+            while (batch.size() < settings.maxBatch) {
+                if (queue.tryPop(record)) {
+                    if (batch.empty()) deadline = chrono::steady_clock::now() + settings.maxLatency;
+                    batch.push_back(move(record));
+                } else if (batch.empty() || stopping.load(memory_order_acquire) ||
+                           chrono::steady_clock::now() >= deadline) {
+                    break;
+                } else {
+                    this_thread::yield();
+                }
+            }
+            
+            if (!batch.empty()) {
+                flush(batch);
+            } else if (stopping.load(memory_order_acquire)) {
+                break;
+            } else {
+                this_thread::sleep_for(chrono::microseconds(200));
+            }
+        }
+    }
+    
+public:
+    IngestionPipeline(const IngestionSettings& config, BatchSink batchSink)
+        : settings(config), queue(config.capacity), sink(move(batchSink)),
+          startedAt(chrono::steady_clock::now()) {
+        consumer = thread(&IngestionPipeline::consumeLoop, this);
+    }
+    
+    ~IngestionPipeline() {
+        stop();
+    }
+    
+    IngestionPipeline(const IngestionPipeline&) = delete;
+    IngestionPipeline& operator=(const IngestionPipeline&) = delete;
+    
+    // Non-blocking submit; false means the ring is full and the caller should back off
+    bool trySubmit(IngestRecord&& record) {
+        if (queue.tryPush(move(record))) {
+            submitted.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        rejected.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    
+    // Blocking submit that waits out back-pressure with a spin-then-sleep backoff
+    void submit(IngestRecord&& record) {
+        int spins = 0;
+        bool waited = false;
+        while (!queue.tryPush(move(record))) {
+            waited = true;
+            if (++spins < 64) {
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::microseconds(50));
+            }
+        }
+        if (waited) backpressureWaits.fetch_add(1, memory_order_relaxed);
+        submitted.fetch_add(1, memory_order_relaxed);
+    }
+    
+    // Drains everything already submitted, then joins the consumer.
+    // Producers must have finished before this is called.
+    void stop() {
+        if (consumer.joinable()) {
+            stopping.store(true, memory_order_release);
+            consumer.join();
+            stoppedAt = chrono::steady_clock::now();
+        }
+    }
+    
+    void printMetrics(ostream& os) const {
+        double seconds = chrono::duration<double>(stoppedAt - startedAt).count();
+        os << "Ingestion: " << applied << " records applied in " << batches << " batches"
+           << " (largest " << largestBatch << ", avg "
+           << fixed << setprecision(1) << (batches ? static_cast<double>(applied) / batches : 0.0) << ")\n";
+        os << "Submitted: " << submitted.load() << ", rejected when full: " << rejected.load()
+           << ", back-pressure waits: " << backpressureWaits.load()
+           << ", ring capacity: " << queue.capacity() << "\n";
+        os << "Throughput: " << fixed << setprecision(0)
+           << (seconds > 0 ? applied / seconds : 0.0) << " records/s over "
+           << setprecision(3) << seconds << " s\n";
+    }
+};
+
+// ------------------------- Export Formatting -------------------------
+enum class ExportFormat {
+    CSV,
+    JSON_LINES,
+    COLUMNAR
+};
+
+// Selects records for export; empty strings match everything, [from, to) is a time range
+struct ExportFilter {
+    string username;
+    string type;
+    time_t from = numeric_limits<time_t>::min();
+    time_t to = numeric_limits<time_t>::max();
+};
+
+// Turns chunks of records into output bytes. Chunks are independent so they
+// can be formatted on worker threads and written in order.
+//
+// Columnar layout: "PFTC" | version, then row groups of
+//   rows(4) | dates(8 x rows) | amounts(4 x rows)
+//   | id, type, description, category, username, currency, account, counter
+//     account columns as offsets(4 x rows+1) + bytes
+// terminated by rows = 0 and the total row count (8).
+class RecordFormatter {
+private:
+    template <typename T>
+    static void appendRaw(string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    
+    static void appendCsvQuoted(string& out, string_view value) {
+        out += '"';
+        for (char c : value) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        out += '"';
+    }
+    
+    static void appendJsonString(string& out, string_view value) {
+        out += '"';
+        for (char c : value) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+    
+    static void appendColumn(string& out, const vector<const Transaction*>& rows,
+                             string_view Transaction::*field) {
+        uint32_t offset = 0;
+        appendRaw(out, offset);
+        for (const Transaction* t : rows) {
+            offset += static_cast<uint32_t>((t->*field).size());
+            appendRaw(out, offset);
+        }
+        for (const Transaction* t : rows) {
+            out.append((t->*field).data(), (t->*field).size());
+        }
+    }
+    
+public:
+    static constexpr uint32_t COLUMNAR_MAGIC = 0x43544650; // "PFTC"
+    static constexpr uint32_t COLUMNAR_VERSION = 3;
+    
+    static bool parseFormat(const string& name, ExportFormat& format) {
+        if (name == "csv") format = ExportFormat::CSV;
+        else if (name == "jsonl" || name == "json") format = ExportFormat::JSON_LINES;
+        else if (name == "columnar" || name == "col") format = ExportFormat::COLUMNAR;
+        else return false;
+        return true;
+    }
+    
+    static string header(ExportFormat format) {
+        string out;
+        if (format == ExportFormat::CSV) {
+            out = "ID,Type,Date,Amount,Description,Category,Username,Currency,Account,CounterAccount\n";
+        } else if (format == ExportFormat::COLUMNAR) {
+            appendRaw(out, COLUMNAR_MAGIC);
+            appendRaw(out, COLUMNAR_VERSION);
+        }
+        return out;
+    }
+    
+    static string footer(ExportFormat format, uint64_t totalRows) {
+        string out;
+        if (format == ExportFormat::COLUMNAR) {
+            appendRaw(out, uint32_t(0));
+            appendRaw(out, totalRows);
+        }
+        return out;
+    }
+    
+    static string formatChunk(ExportFormat format, const vector<const Transaction*>& rows) {
+        string out;
+        char dateBuffer[32];
+        char amountBuffer[32];
+        
+        if (format == ExportFormat::COLUMNAR) {
+            appendRaw(out, static_cast<uint32_t>(rows.size()));
+            for (const Transaction* t : rows) appendRaw(out, static_cast<int64_t>(t->date));
+            for (const Transaction* t : rows) appendRaw(out, t->amount);
+            for (auto field : {&Transaction::id, &Transaction::transactionType, &Transaction::description,
+                               &Transaction::category, &Transaction::username, &Transaction::currency,
+                               &Transaction::account, &Transaction::counterAccount}) {
+                appendColumn(out, rows, field);
+            }
+            return out;
+        }
+        
+        out.reserve(rows.size() * 128);
+        for (const Transaction* t : rows) {
+            int dateLen = DateUtils::formatDateTime(t->date, dateBuffer, sizeof(dateBuffer));
+            int amountLen = snprintf(amountBuffer, sizeof(amountBuffer), "%.2f", t->amount);
+            
+            if (format == ExportFormat::CSV) {
+                out.append(t->id).append(",").append(t->transactionType).append(",");
+                out.append(dateBuffer, dateLen).append(",").append(amountBuffer, amountLen).append(",");
+                appendCsvQuoted(out, t->description);
+                out += ',';
+                appendCsvQuoted(out, t->category);
+                out.append(",").append(t->username).append(",").append(t->currency);
+                out.append(",").append(t->account).append(",").append(t->counterAccount).append("\n");
+            } else {
+                out += "{\"id\":";
+                appendJsonString(out, t->id);
+                out += ",\"type\":";
+                appendJsonString(out, t->transactionType);
+                out += ",\"date\":\"";
+                out.append(dateBuffer, dateLen);
+                out += "\",\"timestamp\":";
+                out += to_string(static_cast<long long>(t->date));
+                out += ",\"amount\":";
+                out.append(amountBuffer, amountLen);
+                out += ",\"description\":";
+                appendJsonString(out, t->description);
+                out += ",\"category\":";
+                appendJsonString(out, t->category);
+                out += ",\"username\":";
+                appendJsonString(out, t->username);
+                out += ",\"currency\":";
+                appendJsonString(out, t->currency);
+                out += ",\"account\":";
+                appendJsonString(out, t->account);
+                if (!t->counterAccount.empty()) {
+                    out += ",\"counter_account\":";
+                    appendJsonString(out, t->counterAccount);
+                }
+                out += "}\n";
+            }
+        }
+        return out;
+    }
+};
+
+// ------------------------- Ledger Snapshots -------------------------
+// Lock-free, point-in-time views of the record set. Records are referenced
+// from an append-only log of fixed-size chunks. Each entry is stamped with
+// the commit version that added it and, once deleted, the version that
+// removed it, so a snapshot at version v sees exactly the entries added at
+// or before v and not removed by v while writers keep committing.
+//
+// Deleted records stay in the log until it is rebuilt into a new epoch
+// without them. Their nodes are parked on the log they were deleted from,
+// and every log keeps its successors alive, so a record is freed only once
+// no snapshot from an epoch that could reach it remains.
+class Ledger {
+public:
+    static constexpr uint64_t LIVE = numeric_limits<uint64_t>::max();
+    
+    struct Entry {
+        const Transaction* record;
+        uint64_t added;
+        atomic<uint64_t> removed;
+    };
+    
+    class Snapshot;
+    
+private:
+    static constexpr size_t CHUNK_SIZE = 4096;
+    static constexpr size_t MIN_CAPACITY = 64 * CHUNK_SIZE;
+    
+    // One epoch. The chunk table is sized up front and never reallocated;
+    // entries past count are invisible to readers.
+    struct Log {
+        vector<unique_ptr<Entry[]>> chunks;
+        atomic<size_t> count{0};
+        size_t deadEntries = 0;
+        atomic<uint64_t> supersededAt{LIVE};
+        shared_ptr<Log> successor;
+        list<Transaction> retired;
+        
+        explicit Log(size_t capacity) : chunks((capacity + CHUNK_SIZE - 1) / CHUNK_SIZE) {}
+        
+        size_t capacity() const {
+            return chunks.size() * CHUNK_SIZE;
+        }
+        
+        Entry& at(size_t i) const {
+            return chunks[i / CHUNK_SIZE][i % CHUNK_SIZE];
+        }
+        
+        // Single writer only
+        size_t push(const Transaction* record, uint64_t added) {
+            size_t i = count.load(memory_order_relaxed);
+            if (!chunks[i / CHUNK_SIZE]) {
+                chunks[i / CHUNK_SIZE].reset(new Entry[CHUNK_SIZE]);
+            }
+            Entry& entry = at(i);
+            entry.record = record;
+            entry.added = added;
+            entry.removed.store(LIVE, memory_order_relaxed);
+            count.store(i + 1, memory_order_release);
+            return i;
+        }
+    };
+    
+    shared_ptr<Log> current = make_shared<Log>(MIN_CAPACITY);
+    atomic<uint64_t> committed{0};
+    
+    // Starts a new epoch holding every live entry, keeping their stamps.
+    // Moved positions are reported through onMove(record, position).
+    template <typename OnMove>
+    void rebuild(OnMove onMove) {
+        size_t entries = current->count.load(memory_order_relaxed);
+        size_t live = entries - current->deadEntries;
+        auto next = make_shared<Log>(max(MIN_CAPACITY, 2 * live + CHUNK_SIZE));
+        for (size_t i = 0; i < entries; i++) {
+            const Entry& entry = current->at(i);
+            if (entry.removed.load(memory_order_relaxed) != LIVE) continue;
+            onMove(entry.record, next->push(entry.record, entry.added));
+        }
+        current->supersededAt.store(committed.load(memory_order_relaxed), memory_order_release);
+        current->successor = next;
+        atomic_store(&current, next);
+    }
+    
+public:
+    // Starts a write. Everything it appends or removes is stamped with the
+    // returned version and becomes visible together on publish. A commit
+    // either appends or removes records, and writers serialize externally
+    // (TransactionManager::storeMutex). Piled-up deleted entries are
+    // dropped here, between commits, so a rebuild never sees a half-done
+    // removal.
+    template <typename OnMove>
+    uint64_t beginCommit(OnMove onMove) {
+        size_t entries = current->count.load(memory_order_relaxed);
+        if (current->deadEntries > max(CHUNK_SIZE, entries / 4)) {
+            rebuild(onMove);
+        }
+        return committed.load(memory_order_relaxed) + 1;
+    }
+    
+    void publish(uint64_t version) {
+        committed.store(version, memory_order_release);
+    }
+    
+    // Appends a record and returns its position in the current epoch
+    template <typename OnMove>
+    size_t append(const Transaction* record, uint64_t version, OnMove onMove) {
+        if (current->count.load(memory_order_relaxed) == current->capacity()) {
+            rebuild(onMove);
+        }
+        return current->push(record, version);
+    }
+    
+    // Marks the entry at position removed and parks its node on this epoch
+    void remove(size_t position, uint64_t version, list<Transaction>& owner, list<Transaction>::iterator node) {
+        current->at(position).removed.store(version, memory_order_release);
+        current->retired.splice(current->retired.end(), owner, node);
+        current->deadEntries++;
+    }
+    
+    // Replaces the contents with records, in order, at positions 0..n-1
+    void reset(const list<Transaction>& records) {
+        auto next = make_shared<Log>(max(MIN_CAPACITY, 2 * records.size() + CHUNK_SIZE));
+        uint64_t version = committed.load(memory_order_relaxed);
+        for (const auto& t : records) {
+            next->push(&t, version);
+        }
+        atomic_store(&current, next);
+    }
+    
+    Snapshot snapshot() const;
+};
+
+class Ledger::Snapshot {
+private:
+    shared_ptr<const Log> log;
+    size_t count = 0;
+    uint64_t version = 0;
+    
+    friend class Ledger;
+    
+public:
+    Snapshot() = default;
+    
+    uint64_t commitVersion() const {
+        return version;
+    }
+    
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        if (!log) return;
+        for (size_t i = 0; i < count; i++) {
+            const Entry& entry = log->at(i);
+            if (entry.added <= version && entry.removed.load(memory_order_acquire) > version) {
+                fn(*entry.record);
+            }
+        }
+    }
+    
+    vector<const Transaction*> records() const {
+        vector<const Transaction*> result;
+        result.reserve(count);
+        forEach([&result](const Transaction& t) { result.push_back(&t); });
+        return result;
+    }
+};
+
+// An epoch replaced after the version was read lacks later writes; retry
+inline Ledger::Snapshot Ledger::snapshot() const {
+    Snapshot snap;
+    for (;;) {
+        shared_ptr<Log> log = atomic_load(&current);
+        uint64_t version = committed.load(memory_order_acquire);
+        if (version <= log->supersededAt.load(memory_order_acquire)) {
+            snap.count = log->count.load(memory_order_acquire);
+            snap.version = version;
+            snap.log = move(log);
+            return snap;
+        }
+    }
+}
+
+// ------------------------- Advanced Data Structures -------------------------
+// Keyset position for paging through the date index. Holds its own copy of
+// the id so it stays valid even if the record it came from is deleted.
+struct RecentCursor {
+    time_t date;
+    string id;
+};
+
+// Orders records oldest-first by (date, id); also compares against cursors
+struct DateOrder {
+    using is_transparent = void;
+    
+    bool operator()(const Transaction* a, const Transaction* b) const {
+        return a->date != b->date ? a->date < b->date : a->id < b->id;
+    }
+    
+    bool operator()(const Transaction* a, const RecentCursor& c) const {
+        return a->date != c.date ? a->date < c.date : a->id < string_view(c.id);
+    }
+    
+    bool operator()(const RecentCursor& c, const Transaction* b) const {
+        return c.date != b->date ? c.date < b->date : string_view(c.id) < b->id;
+    }
+};
+
+using DateIndex = set<const Transaction*, DateOrder>;
+
+// Space amplification is file size over the bytes the live records need.
+// Compaction starts once it reaches maxAmplification and the file is at
+// least minBytes.
+struct CompactionSettings {
+    double maxAmplification;
+    uint64_t minBytes;
+    
+    // FINANCE_TRACKER_COMPACT_RATIO / _MIN_BYTES
+    static CompactionSettings fromConfig() {
+        CompactionSettings settings{2.0, 1 << 20};
+        try {
+            settings.maxAmplification = max(1.1, stod(Config::get("FINANCE_TRACKER_COMPACT_RATIO", "2.0")));
+            settings.minBytes = stoull(Config::get("FINANCE_TRACKER_COMPACT_MIN_BYTES", "1048576"));
+        } catch (...) {
+            cerr << "Invalid compaction settings; using defaults.\n";
+            settings = {2.0, 1 << 20};
+        }
+        return settings;
+    }
+};
+
+struct CompactionReport {
+    uint64_t bytesBefore = 0;
+    uint64_t bytesAfter = 0;
+    size_t liveRecords = 0;
+    double millis = 0;
+    bool ok = false;
+    
+    uint64_t reclaimedBytes() const {
+        return bytesBefore > bytesAfter ? bytesBefore - bytesAfter : 0;
+    }
+};
+
+class TransactionManager {
+private:
+    using Slot = list<Transaction>::iterator;
+    
+    // Where a record lives: its list node and its entry in the ledger epoch
+    struct RecordRef {
+        Slot slot;
+        size_t position;
+    };
+    
+    // Snapshot of the records for a compaction pass, plus the file offset it
+    // covers; segments appended after it are carried over verbatim.
+    struct CompactionJob {
+        Ledger::Snapshot snapshot;
+        uint64_t offset;
+        chrono::steady_clock::time_point started;
+    };
+    
+    RecordArena arena;
+    list<Transaction> transactions; 
+    unordered_map<string_view, RecordRef> transactionMap; 
+    Ledger ledger;
+    DateIndex dateIndex;
+    map<string_view, DateIndex> userDateIndex; 
+    RollupStore rollups;
+    ExchangeRates rates = ExchangeRates::fromConfig();
+    AccountBalances balances;
+    unordered_map<string_view, size_t> unconvertedByUser;  // records without an exchange rate
+    AlertEngine alerts;
+    deque<Alert> alertLog;
+    size_t alertsRaised = 0;
+    SegmentCipher cipher = SegmentCipher::fromConfig();
+    mutex storeMutex;
+    bool loadFailed = false;
+    
+    // Storage accounting and compaction state, guarded by storeMutex
+    CompactionSettings compaction = CompactionSettings::fromConfig();
+    uint64_t fileBytes = 0;
+    uint64_t liveBytes = 0;
+    bool compactionActive = false;
+    CompactionReport lastCompaction;
+    thread compactor;
+    static constexpr uint8_t RECORD_VERSION = 3;
+    static constexpr size_t SEGMENT_CHUNK_SIZE = 1 << 20;
+    const string FILENAME;
+    const string CSV_FILENAME;
+    const string ROLLUP_FILENAME;
+    const string BUDGET_FILENAME;
+    const string RATES_FILENAME;
+    static constexpr size_t ALERT_LOG_SIZE = 100;
+    
+    static const Transaction& recordOf(const Transaction& t) { return t; }
+    static const Transaction& recordOf(const Transaction* t) { return *t; }
+    
+    // Writes records as one encrypted segment, encrypting 1 MiB at a time
+    template <typename Records>
+    bool writeRecordSegment(ostream& os, const Records& records) const {
+        SegmentCipher::Writer writer = cipher.begin(os, SegmentCipher::RECORDS, RECORD_VERSION);
+        ostringstream chunk;
+        string data;
+        for (const auto& record : records) {
+            if (!recordOf(record).writeToFile(chunk)) return false;
+            if (static_cast<size_t>(chunk.tellp()) >= SEGMENT_CHUNK_SIZE) {
+                data = chunk.str();
+                writer.write(data);
+                chunk.str("");
+            }
+        }
+        data = chunk.str();
+        if (!data.empty()) {
+            writer.write(data);
+        }
+        return writer.finish();
+    }
+    
+    bool writeTombstoneSegment(ostream& os, const vector<string_view>& ids) const {
+        ostringstream body;
+        for (string_view id : ids) {
+            size_t len = id.size();
+            body.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            body.write(id.data(), len);
+        }
+        string data = body.str();
+        SegmentCipher::Writer writer = cipher.begin(os, SegmentCipher::TOMBSTONES, RECORD_VERSION);
+        writer.write(data);
+        return writer.finish();
+    }
+    
+    // Appends one segment to the end of the data file. Caller holds storeMutex.
+    template <typename WriteSegment>
+    bool appendSegment(WriteSegment writeSegment) {
+        if (loadFailed) {
+            cerr << "Error: transaction file could not be read at startup; not journaling.\n";
+            return false;
+        }
+        fstream fs(FILENAME, ios::in | ios::out | ios::binary);
+        if (!fs.is_open()) {
+            fs.open(FILENAME, ios::out | ios::binary | ios::trunc);
+        }
+        if (!fs.is_open()) {
+            cerr << "Error: cannot open transaction file for journaling.\n";
+            return false;
+        }
+        fs.seekp(0, ios::end);
+        if (!writeSegment(fs)) {
+            cerr << "Error: failed to append journal segment.\n";
+            return false;
+        }
+        fileBytes = static_cast<uint64_t>(fs.tellp());
+        return true;
+    }
+    
+    // Appends new records to the data file as a journal segment instead of
+    // rewriting the whole store
+    bool appendJournal(const vector<const Transaction*>& records) {
+        return appendSegment([&](ostream& os) { return writeRecordSegment(os, records); });
+    }
+    
+    // Deletes are journaled as tombstones; the record bytes stay in the file
+    // until the next compaction
+    bool appendTombstones(const vector<string_view>& ids) {
+        return appendSegment([&](ostream& os) { return writeTombstoneSegment(os, ids); });
+    }
+    
+    static uint64_t fileSize(const string& path) {
+        ifstream ifs(path, ios::binary | ios::ate);
+        return ifs.is_open() ? static_cast<uint64_t>(ifs.tellg()) : 0;
+    }
+    
+    // What the live records would occupy freshly written as one segment
+    uint64_t compactBytes() const {
+        return liveBytes + SegmentCipher::OVERHEAD;
+    }
+    
+    double spaceAmplification() const {
+        return static_cast<double>(fileBytes) / compactBytes();
+    }
+    
+    // Starts a background pass when the file has outgrown its live data.
+    // Caller holds storeMutex.
+    void maybeCompact() {
+        if (loadFailed || compactionActive || fileBytes < compaction.minBytes ||
+            spaceAmplification() < compaction.maxAmplification) {
+            return;
+        }
+        if (compactor.joinable()) compactor.join();
+        compactor = thread([this, job = beginCompaction()]() mutable {
+            runCompaction(job);
+        });
+    }
+    
+    // Caller holds storeMutex
+    CompactionJob beginCompaction() {
+        compactionActive = true;
+        CompactionJob job;
+        job.started = chrono::steady_clock::now();
+        job.offset = fileBytes;
+        job.snapshot = ledger.snapshot();
+        return job;
+    }
+    
+    // Writes the snapshot as a single segment without holding the lock, then
+    // briefly locks to copy over segments journaled meanwhile and swap files.
+    // In-memory indexes are already up to date, so readers never wait on this.
+    CompactionReport runCompaction(const CompactionJob& job) {
+        CompactionReport report;
+        vector<const Transaction*> live = job.snapshot.records();
+        report.liveRecords = live.size();
+        const string tempFile = FILENAME + ".compact";
+        
+        ofstream out(tempFile, ios::binary | ios::trunc);
+        bool written = out.is_open() && writeRecordSegment(out, live);
+        
+        lock_guard<mutex> lock(storeMutex);
+        if (written) {
+            ifstream old(FILENAME, ios::binary);
+            old.seekg(static_cast<streamoff>(job.offset));
+            vector<char> buffer(1 << 16);
+            while (old && out) {
+                old.read(buffer.data(), buffer.size());
+                out.write(buffer.data(), old.gcount());
+            }
+            out.close();
+            written = old.eof() && out.good();
+        }
+        
+        report.bytesBefore = fileBytes;
+        if (written && rename(tempFile.c_str(), FILENAME.c_str()) == 0) {
+            fileBytes = fileSize(FILENAME);
+            report.bytesAfter = fileBytes;
+            report.ok = true;
+        } else {
+            remove(tempFile.c_str());
+            report.bytesAfter = fileBytes;
+            cerr << "Error: compaction of " << FILENAME << " failed; keeping the existing file.\n";
+        }
+        report.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - job.started).count();
+        
+        compactionActive = false;
+        lastCompaction = report;
+        return report;
+    }
+    
+    void waitForCompaction() {
+        if (compactor.joinable()) compactor.join();
+    }
+    
+    // t's amount in the base currency; false for a currency without rates.
+    // Such records are left out of rollups, balances and alerts, and counted
+    // per user so every view reports them the way the financial report does.
+    bool baseAmount(const Transaction& t, double& value) const {
+        value = rates.convert(t.currency, t.date, t.amount);
+        return !isnan(value);
+    }
+    
+    static void printLeftOut(size_t count) {
+        if (count > 0) {
+            cout << "Left out: " << count << " transactions in currencies without exchange rates\n";
+        }
+    }
+    
+    size_t unconvertedFor(string_view username) const {
+        auto it = unconvertedByUser.find(username);
+        return it != unconvertedByUser.end() ? it->second : 0;
+    }
+    
+    void updateDataStructures() {
+        transactionMap.clear();
+        dateIndex.clear();
+        userDateIndex.clear();
+        liveBytes = 0;
+        alerts.clearStats();
+        balances.clear();
+        unconvertedByUser.clear();
+        
+        unsigned long long digest = 0;
+        size_t converted = 0;
+        size_t position = 0;
+        double value;
+        for (auto it = transactions.begin(); it != transactions.end(); ++it) {
+            indexTransaction(it, position++);
+            if (!baseAmount(*it, value)) {
+                unconvertedByUser[it->username]++;
+                continue;
+            }
+            alerts.observe(*it, value);
+            balances.add(*it, value);
+            digest ^= RollupStore::digestOf(it->id);
+            converted++;
+        }
+        ledger.reset(transactions);
+        
+        // Persisted rollups are reused only if they match the converted
+        // records and were converted with the same exchange rates
+        if (!rollups.load(ROLLUP_FILENAME, converted, digest, rates.digest())) {
+            rollups.clear();
+            for (const auto& t : transactions) {
+                if (baseAmount(t, value)) rollups.add(t, value);
+            }
+            rollups.save(ROLLUP_FILENAME, rates.digest());
+        }
+    }
+    
+    void indexTransaction(Slot slot, size_t position) {
+        const Transaction& t = *slot;
+        transactionMap[t.id] = {slot, position};
+        dateIndex.insert(&t);
+        userDateIndex[t.username].insert(&t);
+        liveBytes += t.encodedSize();
+    }
+    
+    void unindexTransaction(const Transaction& t) {
+        liveBytes -= t.encodedSize();
+        transactionMap.erase(t.id);
+        dateIndex.erase(&t);
+        auto userIt = userDateIndex.find(t.username);
+        if (userIt != userDateIndex.end()) {
+            userIt->second.erase(&t);
+            if (userIt->second.empty()) {
+                userDateIndex.erase(userIt);
+            }
+        }
+    }
+    
+    // Keeps ledger positions in the id map current when an epoch is rebuilt
+    auto relocator() {
+        return [this](const Transaction* t, size_t position) {
+            transactionMap[t->id].position = position;
+        };
+    }
+    
+    // Indexes a newly added record as part of commit version and runs the
+    // alert rules on it; alerts raised are returned and kept in the log.
+    // Caller holds storeMutex.
+    vector<Alert> admitTransaction(Slot slot, uint64_t version) {
+        const Transaction& t = *slot;
+        indexTransaction(slot, ledger.append(&t, version, relocator()));
+        
+        vector<Alert> raised;
+        double value;
+        if (!baseAmount(t, value)) {
+            unconvertedByUser[t.username]++;
+            return raised;
+        }
+        rollups.add(t, value);
+        balances.add(t, value);
+        alerts.evaluate(t, value, rollups, raised);
+        alerts.observe(t, value);
+        for (const Alert& alert : raised) {
+            alertLog.push_back(alert);
+            if (alertLog.size() > ALERT_LOG_SIZE) alertLog.pop_front();
+        }
+        alertsRaised += raised.size();
+        return raised;
+    }
+    
+    const DateIndex* visibleDateIndex(const string& currentUser, UserRole role) const {
+        if (role == UserRole::ADMIN) {
+            return &dateIndex;
+        }
+        auto it = userDateIndex.find(currentUser);
+        return it != userDateIndex.end() ? &it->second : nullptr;
+    }
+    
+public:
+    // filePrefix lets the benchmark keep its data files apart from the real ones
+    explicit TransactionManager(const string& filePrefix = "")
+        : FILENAME(filePrefix + "transactions.dat"),
+          CSV_FILENAME(filePrefix + "transactions.csv"),
+          ROLLUP_FILENAME(filePrefix + "rollups.dat"),
+          BUDGET_FILENAME(filePrefix + "budgets.dat"),
+          RATES_FILENAME(Config::get("FINANCE_TRACKER_RATES_FILE", filePrefix + "rates.csv")) {}
+    
+    ~TransactionManager() {
+        waitForCompaction();
+    }
+    
+    // Builds a record in place from already validated fields and indexes it
+    // without touching the files. Used by the benchmark harness.
+    const Transaction& emplaceTransaction(string_view type, time_t date, float amount,
+                                          string_view desc, string_view cat, string_view user,
+                                          string_view currency = string_view(),
+                                          string_view account = Transaction::DEFAULT_ACCOUNT,
+                                          string_view counterAccount = string_view()) {
+        Transaction& t = transactions.emplace_back();
+        t.assign(arena, type, date, amount, desc, cat, user,
+                 currency.empty() ? string_view(rates.baseCurrency()) : currency, account, counterAccount);
+        uint64_t version = ledger.beginCommit(relocator());
+        admitTransaction(prev(transactions.end()), version);
+        ledger.publish(version);
+        return t;
+    }
+    
+    const RecordArena& recordArena() const {
+        return arena;
+    }
+    
+    const RollupStore& rollupStore() const {
+        return rollups;
+    }
+    
+    const ExchangeRates& exchangeRates() const {
+        return rates;
+    }
+    
+    // Replaces the exchange rates before any records are added. Used by the
+    // benchmark harness.
+    void useExchangeRates(const ExchangeRates::DatedRates& dated) {
+        rates.setRates(dated);
+    }
+    
+    const list<Transaction>& allTransactions() const {
+        return transactions;
+    }
+    
+    // Applies a batch from the ingestion pipeline: records are built in place,
+    // indexed, and journaled as a single segment
+    void applyBatch(vector<IngestRecord>& batch) {
+        lock_guard<mutex> lock(storeMutex);
+        vector<const Transaction*> added;
+        added.reserve(batch.size());
+        size_t oversized = 0;
+        uint64_t version = ledger.beginCommit(relocator());
+        for (const auto& r : batch) {
+            // Producers validate too; this keeps unreadable records out of the file
+            if (!Transaction::fitsStoredLimits(r.description, r.category)) {
+                oversized++;
+                continue;
+            }
+            Transaction& t = transactions.emplace_back();
+            t.assign(arena, r.type, r.date, r.amount, r.description, r.category, r.username,
+                     r.currency.empty() ? rates.baseCurrency() : r.currency,
+                     r.account.empty() ? Transaction::DEFAULT_ACCOUNT : r.account, r.counterAccount);
+            admitTransaction(prev(transactions.end()), version);
+            added.push_back(&t);
+        }
+        ledger.publish(version);
+        if (oversized > 0) {
+            cerr << "Warning: dropped " << oversized << " records with an oversized description or category.\n";
+        }
+        if (appendJournal(added)) maybeCompact();
+    }
+    
+    // Persists the derived indexes after journaled writes
+    void persistIndexes() {
+        if (!loadFailed && !rollups.save(ROLLUP_FILENAME, rates.digest())) {
+            cerr << "Error saving rollups to " << ROLLUP_FILENAME << endl;
         }
     }
-};
-
-// ------------------------- Advanced Data Structures -------------------------
-class TransactionManager {
-private:
-    list<Transaction> transactions; 
-    unordered_map<string, Transaction> transactionMap; 
-    queue<Transaction> recentTransactions; 
-    map<string, vector<Transaction>> userTransactions; 
-    const string FILENAME = "transactions.dat";
-    const string CSV_FILENAME = "transactions.csv";
     
-    void updateDataStructures() {
-        transactionMap.clear();
-        userTransactions.clear();
+    // Appends every record segment in the stream to the store. A stream that
+    // does not start with a segment is read as legacy XOR records. Returns
+    // true if the file should be rewritten: legacy format or a torn tail.
+    bool readStore(istream& is) {
+        if (!SegmentCipher::startsWithSegment(is)) {
+            while (is.peek() != EOF) {
+                Transaction& t = transactions.emplace_back();
+                if (!t.readFromFile(is, arena, 1, true)) {
+                    transactions.pop_back();
+                    break;
+                }
+            }
+            fillDefaults();
+            return true;
+        }
         
+        // Tombstones only ever refer to records in earlier segments
+        unordered_map<string_view, Slot> loaded;
+        vector<char> payload;
+        uint8_t kind, recordVersion;
+        while (is.peek() != EOF) {
+            if (!cipher.readSegment(is, kind, recordVersion, payload)) {
+                cerr << "Warning: ignoring incomplete trailing segment in transaction file.\n";
+                fillDefaults();
+                return true;
+            }
+            if (kind != SegmentCipher::RECORDS && kind != SegmentCipher::TOMBSTONES) continue;
+            if (recordVersion < 1 || recordVersion > RECORD_VERSION) {
+                throw runtime_error("Unsupported record version " + to_string(recordVersion));
+            }
+            
+            MemoryStreamBuf buffer(payload.data(), payload.size());
+            istream records(&buffer);
+            while (records.peek() != EOF) {
+                if (kind == SegmentCipher::TOMBSTONES) {
+                    size_t len = 0;
+                    records.read(reinterpret_cast<char*>(&len), sizeof(len));
+                    if (!records.good() || len > payload.size()) {
+                        throw runtime_error("Malformed tombstone segment");
+                    }
+                    string id(len, '\0');
+                    records.read(&id[0], len);
+                    auto it = loaded.find(id);
+                    if (it != loaded.end()) {
+                        transactions.erase(it->second);
+                        loaded.erase(it);
+                    }
+                    continue;
+                }
+                Transaction& t = transactions.emplace_back();
+                if (!t.readFromFile(records, arena, recordVersion)) {
+                    transactions.pop_back();
+                    throw runtime_error("Malformed record in transaction segment");
+                }
+                loaded[t.id] = prev(transactions.end());
+            }
+        }
+        return fillDefaults();
+    }
+    
+    // Records from before currencies and accounts were tracked are in the
+    // base currency and the default account. Returns true if any were found,
+    // so the store is rewritten with them.
+    bool fillDefaults() {
+        string_view base = arena.intern(rates.baseCurrency());
+        string_view defaultAccount = arena.intern(Transaction::DEFAULT_ACCOUNT);
+        bool filled = false;
+        for (auto& t : transactions) {
+            if (t.currency.empty()) {
+                t.currency = base;
+                filled = true;
+            }
+            if (t.account.empty()) {
+                t.account = defaultAccount;
+                filled = true;
+            }
+        }
+        return filled;
+    }
+    
+    // Stores written before IDs were unique across runs can hold the same ID
+    // twice. Later copies get fresh IDs so the id map, date index and
+    // tombstones each refer to exactly one record; returns true if any did.
+    bool renumberDuplicateIds() {
         for (const auto& t : transactions) {
-            transactionMap[t.id] = t;
-            userTransactions[t.username].push_back(t);
+            Transaction::reserveIdsAbove(t.id);
+        }
+        unordered_set<string_view> seen;
+        size_t renumbered = 0;
+        for (auto& t : transactions) {
+            if (seen.insert(t.id).second) continue;
+            string_view old = t.id;
+            t.generateId(arena);
+            seen.insert(t.id);
+            cerr << "Warning: duplicate transaction ID " << old << " renumbered to " << t.id << ".\n";
+            renumbered++;
         }
+        return renumbered > 0;
+    }
+    
+    bool writeStore(ostream& os) const {
+        return writeRecordSegment(os, transactions);
     }
     
-public:
     void loadTransactions() {
+        alerts.load(BUDGET_FILENAME);
+        if (rates.load(RATES_FILENAME)) {
+            cout << "Loaded exchange rates into " << rates.baseCurrency() << " from " << RATES_FILENAME << ".\n";
+        }
         try {
             ifstream ifs(FILENAME, ios::binary);
             if (!ifs.is_open()) {
                 cout << "No existing transaction file found. Starting fresh.\n";
                 return;
             }
+            if (!Config::isSet("FINANCE_TRACKER_KEY")) {
+                cout << "Warning: FINANCE_TRACKER_KEY is not set; using the built-in storage key.\n";
+            }
             
             transactions.clear();
+            arena.clear();
             
-            while (ifs.peek() != EOF) {
-                Transaction t;
-                if (t.readFromFile(ifs)) {
-                    transactions.push_back(t);
-                } else {
-                    break;
-                }
-            }
+            bool needsRewrite = readStore(ifs);
             ifs.close();
+            needsRewrite = renumberDuplicateIds() || needsRewrite;
+            fileBytes = fileSize(FILENAME);
             
             updateDataStructures();
             cout << "Loaded " << transactions.size() << " transactions from file.\n";
+            
+            if (needsRewrite && !transactions.empty()) {
+                cout << "Rewriting transaction file in the current segment format.\n";
+                saveTransactions();
+            }
         } catch (const exception& e) {
             cerr << "Error loading transactions: " << e.what() << endl;
+            cerr << "Transaction file will not be overwritten this session.\n";
+            loadFailed = true;
             transactions.clear();
+            ledger.reset(transactions);
             transactionMap.clear();
-            userTransactions.clear();
+            dateIndex.clear();
+            userDateIndex.clear();
+            rollups.clear();
+            balances.clear();
+            unconvertedByUser.clear();
+            alerts.clearStats();
+            liveBytes = 0;
         }
     }
     
     void saveTransactions() {
         try {
-            // Saving binary format
+            if (loadFailed) {
+                throw runtime_error("Transaction file could not be read at startup");
+            }
+            waitForCompaction();
+            
+            // Saving encrypted binary format
             ofstream ofs(FILENAME, ios::binary | ios::trunc);
             if (!ofs.is_open()) {
                 throw runtime_error("Cannot open transaction file for writing");
             }
             
-            for (const auto& t : transactions) {
-                if (!t.writeToFile(ofs)) {
-                    throw runtime_error("Failed to write transaction data");
-                }
+            if (!writeStore(ofs)) {
+                throw runtime_error("Failed to write transaction data");
             }
             ofs.close();
+            fileBytes = fileSize(FILENAME);
+            
+            if (!rollups.save(ROLLUP_FILENAME, rates.digest())) {
+                throw runtime_error("Failed to write rollup data");
+            }
             
             // saving CSV format
             saveTransactionsCSV();
@@ -491,104 +3662,176 @@ public:
         }
     }
     
+    // The CSV may be the last readable copy when the store failed to load,
+    // so it is left alone then
     void saveTransactionsCSV() {
+        if (loadFailed) {
+            cerr << "Transaction file could not be read at startup; not rewriting " << CSV_FILENAME << ".\n";
+            return;
+        }
+        size_t rows;
+        exportTransactions(ExportFilter(), ExportFormat::CSV, CSV_FILENAME, rows);
+    }
+    
+    // Streams matching records to a file in date order. Rows are gathered from
+    // the date index in fixed-size chunks, formatted on worker threads and
+    // written in order; at most one chunk per worker is in flight, so memory
+    // stays bounded however many rows match.
+    bool exportTransactions(const ExportFilter& filter, ExportFormat format, const string& path, size_t& rows) {
+        rows = 0;
         try {
-            ofstream csvFile(CSV_FILENAME, ios::trunc);
-            if (!csvFile.is_open()) {
-                throw runtime_error("Cannot open CSV file for writing");
+            ofstream out(path, ios::binary | ios::trunc);
+            if (!out.is_open()) {
+                throw runtime_error("Cannot open " + path + " for writing");
             }
             
-            // Write header
-            csvFile << "ID,Type,Date,Amount,Description,Category,Username\n";
+            const DateIndex* index = &dateIndex;
+            if (!filter.username.empty()) {
+                auto userIt = userDateIndex.find(filter.username);
+                if (userIt == userDateIndex.end()) index = nullptr;
+                else index = &userIt->second;
+            }
             
-            // Write data
-            for (const auto& t : transactions) {
-                // Format date
-                stringstream dateStream;
-                dateStream << put_time(localtime(&t.date), "%Y-%m-%d %H:%M:%S");
-                
-                // Escape quotes in description and category
-                string desc = t.description;
-                string cat = t.category;
+            const size_t chunkRows = 16384;
+            const size_t window = max(1u, thread::hardware_concurrency());
+            deque<future<string>> inFlight;
+            auto writeOldest = [&]() {
+                string bytes = inFlight.front().get();
+                inFlight.pop_front();
+                out.write(bytes.data(), bytes.size());
+            };
+            
+            string header = RecordFormatter::header(format);
+            out.write(header.data(), header.size());
+            
+            if (index) {
+                auto it = index->lower_bound(RecentCursor{filter.from, ""});
+                vector<const Transaction*> chunk;
+                chunk.reserve(chunkRows);
                 
-                // Replace quotes with double quotes for CSV escaping
-                size_t pos = 0;
-                while ((pos = desc.find('"', pos)) != string::npos) {
-                    desc.replace(pos, 1, "\"\"");
-                    pos += 2;
-                }
-                pos = 0;
-                while ((pos = cat.find('"', pos)) != string::npos) {
-                    cat.replace(pos, 1, "\"\"");
-                    pos += 2;
+                for (;; ++it) {
+                    bool done = it == index->end() || (*it)->date >= filter.to;
+                    if (!done && (filter.type.empty() || (*it)->transactionType == filter.type)) {
+                        chunk.push_back(*it);
+                    }
+                    if (chunk.size() == chunkRows || (done && !chunk.empty())) {
+                        rows += chunk.size();
+                        if (inFlight.size() == window) writeOldest();
+                        inFlight.push_back(async(launch::async, [format, rows = move(chunk)]() {
+                            return RecordFormatter::formatChunk(format, rows);
+                        }));
+                        chunk = vector<const Transaction*>();
+                        chunk.reserve(chunkRows);
+                    }
+                    if (done) break;
                 }
-                
-                csvFile << t.id << ","
-                       << t.transactionType << ","
-                       << dateStream.str() << ","
-                       << fixed << setprecision(2) << t.amount << ","
-                       << "\"" << desc << "\","
-                       << "\"" << cat << "\","
-                       << t.username << "\n";
-            }
-            csvFile.close();
+            }
+            while (!inFlight.empty()) {
+                writeOldest();
+            }
+            
+            string footer = RecordFormatter::footer(format, rows);
+            out.write(footer.data(), footer.size());
+            out.close();
+            if (!out) {
+                throw runtime_error("Failed writing " + path);
+            }
+            return true;
         } catch (const exception& e) {
-            cerr << "Error saving CSV: " << e.what() << endl;
+            cerr << "Error exporting transactions: " << e.what() << endl;
+            return false;
         }
     }
     
     void addTransaction(const string& currentUser) {
         try {
-            Transaction t;
-            t.input(currentUser);
+            Transaction input;
+            input.input(currentUser, arena, rates.baseCurrency());
+            if (rates.idOf(input.currency) == rates.unknownId()) {
+                cout << "Warning: no exchange rate for " << input.currency
+                     << "; it is left out of totals until one is added to " << RATES_FILENAME << ".\n";
+            }
             
-            transactions.push_back(t);
-            transactionMap[t.id] = t;
-            userTransactions[t.username].push_back(t);
+            lock_guard<mutex> lock(storeMutex);
+            const Transaction& t = transactions.emplace_back(input);
+            uint64_t version = ledger.beginCommit(relocator());
+            vector<Alert> raised = admitTransaction(prev(transactions.end()), version);
+            ledger.publish(version);
             
-            // Add to recent transactions queue (keep only last 10)
-            recentTransactions.push(t);
-            if (recentTransactions.size() > 10) {
-                recentTransactions.pop();
+            if (!appendJournal({&t})) {
+                throw runtime_error("Transaction kept in memory only");
             }
-            
-            saveTransactions();
+            // Rollups are persisted on logout; a stale file fails the
+            // count/digest check on load and is rebuilt
+            maybeCompact();
             cout << "Transaction added successfully with ID: " << t.id << endl;
+            for (const Alert& alert : raised) {
+                cout << "ALERT: " << alert.message << "\n";
+            }
         } catch (const exception& e) {
             cerr << "Error adding transaction: " << e.what() << endl;
         }
     }
     
+    // Scans run on a ledger snapshot, so concurrent writers neither block
+    // them nor change what they see part-way through
     void displayAllTransactions(const string& currentUser, UserRole role) {
-        if (transactions.empty()) {
-            cout << "No transactions available.\n";
-            return;
-        }
-        
+        Ledger::Snapshot snapshot = ledger.snapshot();
         cout << "\n=== All Transactions ===\n";
         int count = 0;
-        for (const auto& t : transactions) {
+        snapshot.forEach([&](const Transaction& t) {
             // Standard users can only see their own transactions
             if (role == UserRole::STANDARD && t.username != currentUser) {
-                continue;
+                return;
             }
             t.display();
             count++;
+        });
+        if (count == 0) {
+            cout << "No transactions available.\n";
+            return;
         }
         cout << "Total transactions displayed: " << count << "\n";
     }
     
-    void displayRecentTransactions() {
-        if (recentTransactions.empty()) {
+    // Newest-first page of at most pageSize records strictly older than the
+    // cursor (or the newest records when cursor is null). O(log n + pageSize).
+    vector<const Transaction*> recentTransactionsPage(const string& currentUser, UserRole role,
+                                                      size_t pageSize, const RecentCursor* cursor) const {
+        vector<const Transaction*> page;
+        const DateIndex* index = visibleDateIndex(currentUser, role);
+        if (!index || pageSize == 0) return page;
+        
+        auto it = cursor ? index->lower_bound(*cursor) : index->end();
+        while (it != index->begin() && page.size() < pageSize) {
+            --it;
+            page.push_back(*it);
+        }
+        return page;
+    }
+    
+    void displayRecentTransactions(const string& currentUser, UserRole role, size_t pageSize) {
+        vector<const Transaction*> page = recentTransactionsPage(currentUser, role, pageSize, nullptr);
+        if (page.empty()) {
             cout << "No recent transactions.\n";
             return;
         }
         
         cout << "\n=== Recent Transactions ===\n";
-        queue<Transaction> tempQueue = recentTransactions;
-        while (!tempQueue.empty()) {
-            tempQueue.front().display();
-            tempQueue.pop();
+        while (!page.empty()) {
+            for (const Transaction* t : page) {
+                t->display();
+            }
+            if (page.size() < pageSize) break;
+            
+            RecentCursor cursor{page.back()->date, string(page.back()->id)};
+            page = recentTransactionsPage(currentUser, role, pageSize, &cursor);
+            if (page.empty()) break;
+            
+            string more;
+            cout << "Show older transactions? (y/n): ";
+            cin >> more;
+            if (more != "y" && more != "Y") break;
         }
     }
     
@@ -596,7 +3839,7 @@ public:
         auto it = transactionMap.find(id);
         if (it != transactionMap.end()) {
             cout << "\n=== Transaction Found ===\n";
-            it->second.display();
+            it->second.slot->display();
         } else {
             cout << "Transaction with ID " << id << " not found.\n";
         }
@@ -606,9 +3849,9 @@ public:
         bool found = false;
         cout << "\n=== Transactions on " << dateStr << " ===\n";
         
-        for (const auto& t : transactions) {
+        ledger.snapshot().forEach([&](const Transaction& t) {
             if (role == UserRole::STANDARD && t.username != currentUser) {
-                continue;
+                return;
             }
             
             stringstream ss;
@@ -617,7 +3860,7 @@ public:
                 t.display();
                 found = true;
             }
-        }
+        });
         
         if (!found) cout << "No transactions found on that date.\n";
     }
@@ -626,87 +3869,467 @@ public:
         bool found = false;
         cout << "\n=== Transactions of type: " << type << " ===\n";
         
-        for (const auto& t : transactions) {
+        ledger.snapshot().forEach([&](const Transaction& t) {
             if (role == UserRole::STANDARD && t.username != currentUser) {
-                continue;
+                return;
             }
             
             if (t.transactionType == type) {
                 t.display();
                 found = true;
             }
-        }
+        });
         
         if (!found) cout << "No transactions found with that type.\n";
     }
     
     void showTotalByType(const string& type, const string& currentUser, UserRole role) {
-        float total = 0.0;
+        double total = 0.0;
         int count = 0;
+        size_t leftOut = 0;
         
-        for (const auto& t : transactions) {
+        ledger.snapshot().forEach([&](const Transaction& t) {
             if (role == UserRole::STANDARD && t.username != currentUser) {
-                continue;
+                return;
             }
             
+            double value;
             if (t.transactionType == type) {
-                total += t.amount;
+                if (!baseAmount(t, value)) {
+                    leftOut++;
+                    return;
+                }
+                total += value;
                 count++;
             }
+        });
+        
+        if (count > 0) {
+            cout << "Total for transaction type \"" << type << "\": " 
+                 << fixed << setprecision(2) << total << " " << rates.baseCurrency()
+                 << " (" << count << " transactions)\n";
+        } else {
+            cout << "No transactions found with that type.\n";
+        }
+        printLeftOut(leftOut);
+    }
+    
+    struct ReportTotals {
+        double income = 0, expense = 0, savings = 0, investment = 0, transfers = 0;
+        int count = 0;
+        int unconverted = 0;        // rows in currencies without exchange rates
+        int unlinkedTransfers = 0;  // transfers recorded without a counter account
+        vector<pair<string, double>> accounts;  // posted balance per account
+        
+        // Sum of the account balances; transfers move money between accounts
+        // and cancel out
+        double netWorth() const {
+            double total = 0;
+            for (const auto& account : accounts) total += account.second;
+            return total;
+        }
+    };
+    
+    // Totals in the base currency over one snapshot of the records dated
+    // before `before`, with each row posted to its accounts. Matching rows
+    // are gathered into fixed-size column batches and converted in one pass
+    // over the dense rate table.
+    ReportTotals reportTotals(const Ledger::Snapshot& snapshot, const string& currentUser,
+                              UserRole role, time_t before) const {
+        static constexpr size_t BATCH = 1024;
+        static constexpr uint32_t NO_ACCOUNT = numeric_limits<uint32_t>::max();
+        enum Kind : uint8_t { INCOME, EXPENSE, SAVINGS, INVESTMENT, TRANSFER, UNLINKED };
+        static constexpr double DEBIT_SIGN[] = {1, -1, 1, 1, -1, 0};
+        array<uint8_t, BATCH> kinds;
+        array<uint16_t, BATCH> currencies;
+        array<int, BATCH> days;
+        array<float, BATCH> amounts;
+        array<double, BATCH> values;
+        array<uint32_t, BATCH> debited, credited;
+        size_t pending = 0;
+        double sums[UNLINKED + 1] = {};
+        ExchangeRates::IdCache currencyId(rates);
+        ReportTotals totals;
+        
+        // Accounts are numbered as they are met; user and account names are
+        // interned, so their addresses identify them
+        map<pair<const char*, const char*>, uint32_t> accountIds;
+        vector<pair<string, double>> accounts;
+        auto accountId = [&](string_view username, string_view account) {
+            auto [it, added] = accountIds.emplace(make_pair(username.data(), account.data()),
+                                                  static_cast<uint32_t>(accounts.size()));
+            if (added) {
+                string label = role == UserRole::ADMIN ? string(username) + "/" + string(account) : string(account);
+                accounts.emplace_back(move(label), 0.0);
+            }
+            return it->second;
+        };
+        
+        auto flush = [&]() {
+            rates.convertBatch(currencies.data(), days.data(), amounts.data(), values.data(), pending);
+            for (size_t i = 0; i < pending; i++) {
+                if (isnan(values[i])) {
+                    totals.unconverted++;
+                    continue;
+                }
+                sums[kinds[i]] += values[i];
+                accounts[debited[i]].second += DEBIT_SIGN[kinds[i]] * values[i];
+                if (credited[i] != NO_ACCOUNT) accounts[credited[i]].second += values[i];
+            }
+            pending = 0;
+        };
+        
+        snapshot.forEach([&](const Transaction& t) {
+            if ((role == UserRole::STANDARD && t.username != currentUser) || t.date >= before) {
+                return;
+            }
+            
+            totals.count++;
+            Kind kind = t.transactionType == "income" ? INCOME
+                      : t.transactionType == "expense" ? EXPENSE
+                      : t.transactionType == "savings" ? SAVINGS
+                      : t.transactionType == "investment" ? INVESTMENT
+                      : t.counterAccount.empty() ? UNLINKED : TRANSFER;
+            kinds[pending] = kind;
+            currencies[pending] = currencyId(t.currency);
+            days[pending] = DateUtils::localDay(t.date);
+            amounts[pending] = t.amount;
+            debited[pending] = accountId(t.username, t.account);
+            credited[pending] = kind == TRANSFER ? accountId(t.username, t.counterAccount) : NO_ACCOUNT;
+            if (kind == UNLINKED) totals.unlinkedTransfers++;
+            if (++pending == BATCH) flush();
+        });
+        flush();
+        
+        totals.income = sums[INCOME];
+        totals.expense = sums[EXPENSE];
+        totals.savings = sums[SAVINGS];
+        totals.investment = sums[INVESTMENT];
+        totals.transfers = sums[TRANSFER];
+        sort(accounts.begin(), accounts.end());
+        totals.accounts = move(accounts);
+        return totals;
+    }
+    
+    Ledger::Snapshot snapshot() const {
+        return ledger.snapshot();
+    }
+    
+    // asOfStr is a YYYY-MM-DD date to report the ledger as of the end of
+    // that day, or "-" for everything
+    void generateReport(const string& currentUser, UserRole role, const string& asOfStr) {
+        time_t before = numeric_limits<time_t>::max();
+        int asOfDay;
+        if (asOfStr != "-") {
+            if (!DateUtils::parseDate(asOfStr, asOfDay)) {
+                cout << "Invalid date.\n";
+                return;
+            }
+            before = DateUtils::startOfDay(asOfDay + 1);
+        }
+        
+        Ledger::Snapshot snapshot = ledger.snapshot();
+        ReportTotals totals = reportTotals(snapshot, currentUser, role, before);
+        
+        cout << "\n=== Financial Report";
+        if (asOfStr != "-") cout << " as of " << asOfStr;
+        cout << " (snapshot v" << snapshot.commitVersion() << ") ===\n";
+        const string& base = rates.baseCurrency();
+        cout << "Total Transactions: " << totals.count << "\n";
+        cout << "Total Income: " << fixed << setprecision(2) << totals.income << " " << base << "\n";
+        cout << "Total Expenses: " << totals.expense << " " << base << "\n";
+        cout << "Total Savings: " << totals.savings << " " << base << "\n";
+        cout << "Total Investments: " << totals.investment << " " << base << "\n";
+        cout << "Transfers Between Accounts: " << totals.transfers << " " << base << "\n";
+        for (const auto& [account, balance] : totals.accounts) {
+            cout << "  Account " << account << ": " << balance << " " << base << "\n";
+        }
+        cout << "Net Worth: " << totals.netWorth() << " " << base << "\n";
+        if (totals.unlinkedTransfers > 0) {
+            cout << "Not posted: " << totals.unlinkedTransfers << " transfers without a destination account\n";
+        }
+        printLeftOut(totals.unconverted);
+    }
+    
+    // True if path names one of the tracker's own files or a compaction temp file
+    bool isProtectedPath(const string& path) const {
+        namespace fs = std::filesystem;
+        error_code ec;
+        fs::path target = fs::weakly_canonical(fs::absolute(path, ec), ec);
+        if (ec || target.extension() == ".compact") return true;
+        for (const string& own : {FILENAME, CSV_FILENAME, ROLLUP_FILENAME, BUDGET_FILENAME, RATES_FILENAME,
+                                  string(UserManager::USER_FILE), string(UserManager::SESSION_FILE)}) {
+            if (fs::weakly_canonical(fs::absolute(own, ec), ec) == target) return true;
+        }
+        return false;
+    }
+    
+    // Resolves where an export may be written. Administrators may name any
+    // path except the tracker's own files; other users give a plain file name
+    // that is created in the export directory (FINANCE_TRACKER_EXPORT_DIR,
+    // default "exports") and never replaces an existing file.
+    bool resolveExportPath(const string& requested, UserRole role, string& resolved) const {
+        namespace fs = std::filesystem;
+        resolved = requested;
+        if (role != UserRole::ADMIN) {
+            if (requested.empty() || requested.find_first_of("/\\") != string::npos ||
+                requested == "." || requested == "..") {
+                cout << "Give a file name only; exports are written to the export directory.\n";
+                return false;
+            }
+            fs::path dir = Config::get("FINANCE_TRACKER_EXPORT_DIR", "exports");
+            error_code ec;
+            fs::create_directories(dir, ec);
+            resolved = (dir / requested).string();
+            if (fs::exists(resolved, ec)) {
+                cout << "Export file " << resolved << " already exists.\n";
+                return false;
+            }
+        }
+        if (isProtectedPath(resolved)) {
+            cout << "Refusing to export over the tracker's own file " << resolved << ".\n";
+            return false;
+        }
+        return true;
+    }
+    
+    // Parses user-facing export arguments ('all' and '-' mean unrestricted) and runs the export
+    bool runExport(const string& formatName, const string& requestedPath, const string& username,
+                   const string& fromStr, const string& toStr, const string& type, UserRole role) {
+        ExportFormat format;
+        if (!RecordFormatter::parseFormat(formatName, format)) {
+            cout << "Unknown export format: " << formatName << "\n";
+            return false;
+        }
+        string path;
+        if (!resolveExportPath(requestedPath, role, path)) {
+            return false;
+        }
+        
+        ExportFilter filter;
+        filter.username = username == "all" ? "" : username;
+        filter.type = type == "all" ? "" : type;
+        int day;
+        if (fromStr != "-") {
+            if (!DateUtils::parseDate(fromStr, day)) {
+                cout << "Invalid from date.\n";
+                return false;
+            }
+            filter.from = DateUtils::startOfDay(day);
+        }
+        if (toStr != "-") {
+            if (!DateUtils::parseDate(toStr, day)) {
+                cout << "Invalid to date.\n";
+                return false;
+            }
+            filter.to = DateUtils::startOfDay(day + 1);
+        }
+        
+        size_t rows;
+        auto start = chrono::steady_clock::now();
+        if (!exportTransactions(filter, format, path, rows)) return false;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Exported " << rows << " transactions to " << path << " in "
+             << fixed << setprecision(2) << seconds << " s.\n";
+        return true;
+    }
+    
+    void showRollup(const string& username, const string& type, const string& fromStr,
+                    const string& toStr, const string& groupBy) {
+        int fromDay, toDay;
+        if (!DateUtils::parseDate(fromStr, fromDay) || !DateUtils::parseDate(toStr, toDay) || fromDay > toDay) {
+            cout << "Invalid date range.\n";
+            return;
+        }
+        
+        map<string, RollupCell> totals = rollups.totalsByCategory(username, type, fromDay, toDay);
+        if (totals.empty()) {
+            cout << "No " << type << " transactions in that period.\n";
+            printLeftOut(unconvertedFor(username));
+            return;
+        }
+        
+        cout << "\n=== " << type << " by category, " << fromStr << " to " << toStr << " ===\n";
+        for (const auto& [category, total] : totals) {
+            cout << category << ": " << fixed << setprecision(2) << total.sum << " " << rates.baseCurrency()
+                 << " (" << total.count << " transactions)\n";
+            
+            if (groupBy == "total") continue;
+            RollupStore::Period period = groupBy == "day" ? RollupStore::Period::DAY
+                                       : groupBy == "year" ? RollupStore::Period::YEAR
+                                       : RollupStore::Period::MONTH;
+            for (const auto& [bucket, cell] : rollups.periodSeries(username, type, category, period, fromDay, toDay)) {
+                cout << "  " << RollupStore::bucketLabel(period, bucket) << ": "
+                     << fixed << setprecision(2) << cell.sum << " (" << cell.count << ")\n";
+            }
+        }
+        printLeftOut(unconvertedFor(username));
+    }
+    
+    void deleteTransaction(const string& id, UserRole role) {
+        if (role != UserRole::ADMIN) {
+            cout << "Access denied. Only administrators can delete transactions.\n";
+            return;
+        }
+        
+        try {
+            if (removeTransaction(id)) {
+                cout << "Transaction deleted successfully.\n";
+            } else {
+                cout << "Transaction not found.\n";
+            }
+        } catch (const exception& e) {
+            cerr << "Error deleting transaction: " << e.what() << endl;
+        }
+    }
+    
+    // Drops the record from memory and journals a tombstone for it. Rollups
+    // are persisted on exit; if that never happens, the count/digest check
+    // on the next load rebuilds them.
+    bool removeTransaction(const string& id) {
+        lock_guard<mutex> lock(storeMutex);
+        if (transactionMap.find(id) == transactionMap.end()) {
+            return false;
+        }
+        
+        // Looked up after beginCommit, which may move ledger positions
+        uint64_t version = ledger.beginCommit(relocator());
+        RecordRef ref = transactionMap.find(id)->second;
+        if (!appendTombstones({ref.slot->id})) {
+            throw runtime_error("Could not record deletion of " + id);
+        }
+        unindexTransaction(*ref.slot);
+        double value;
+        if (baseAmount(*ref.slot, value)) {
+            rollups.remove(*ref.slot, value);
+            balances.remove(*ref.slot, value);
+            alerts.forget(*ref.slot, value);
+        } else if (--unconvertedByUser[ref.slot->username] == 0) {
+            unconvertedByUser.erase(ref.slot->username);
+        }
+        // Snapshots may still be reading the record; the ledger frees it later
+        ledger.remove(ref.position, version, transactions, ref.slot);
+        ledger.publish(version);
+        maybeCompact();
+        return true;
+    }
+    
+    // asOfStr is a YYYY-MM-DD date, or "-" for today; each balance is one
+    // prefix query on the account's running totals
+    void showBalances(const string& username, const string& asOfStr) {
+        int day = DateUtils::localDay(time(0));
+        if (asOfStr != "-" && !DateUtils::parseDate(asOfStr, day)) {
+            cout << "Invalid date.\n";
+            return;
+        }
+        
+        lock_guard<mutex> lock(storeMutex);
+        vector<pair<string, double>> userBalances = balances.balancesFor(username, day);
+        if (userBalances.empty()) {
+            cout << "No accounts for " << username << ".\n";
+            return;
+        }
+        
+        double total = 0;
+        cout << "\n=== Account balances for " << username << " at end of " << DateUtils::formatDay(day) << " ===\n";
+        for (const auto& [account, balance] : userBalances) {
+            cout << left << setw(20) << account << right << fixed << setprecision(2)
+                 << setw(14) << balance << " " << rates.baseCurrency() << "\n";
+            total += balance;
+        }
+        cout << left << setw(20) << "Total" << right << setw(14) << total << " " << rates.baseCurrency() << "\n";
+        printLeftOut(unconvertedFor(username));
+    }
+    
+    double accountBalance(const string& username, const string& account, int day) {
+        lock_guard<mutex> lock(storeMutex);
+        return balances.balance(username, account, day);
+    }
+    
+    void setBudget(const string& username, const string& category, double limit) {
+        lock_guard<mutex> lock(storeMutex);
+        alerts.setBudget(username, category, limit);
+        if (!alerts.save(BUDGET_FILENAME)) {
+            cerr << "Error saving budgets to " << BUDGET_FILENAME << endl;
+        }
+    }
+    
+    size_t alertCount() const {
+        return alertsRaised;
+    }
+    
+    // Most recent alerts, oldest first; standard users only see their own
+    void showAlerts(const string& currentUser, UserRole role, ostream& os) {
+        lock_guard<mutex> lock(storeMutex);
+        size_t shown = 0;
+        for (const Alert& alert : alertLog) {
+            if (role == UserRole::STANDARD && alert.username != currentUser) continue;
+            os << "[" << alert.username << "] " << alert.message << "\n";
+            shown++;
+        }
+        if (shown == 0) os << "No alerts.\n";
+    }
+    
+    // Current month's spending against each budget, with the category's history
+    void showBudgets(const string& username) {
+        lock_guard<mutex> lock(storeMutex);
+        vector<pair<string, double>> userBudgets = alerts.budgetsFor(username);
+        if (userBudgets.empty()) {
+            cout << "No budgets set for " << username << ".\n";
+            return;
         }
         
-        if (count > 0) {
-            cout << "Total for transaction type \"" << type << "\": $" 
-                 << fixed << setprecision(2) << total 
-                 << " (" << count << " transactions)\n";
-        } else {
-            cout << "No transactions found with that type.\n";
+        int today = DateUtils::localDay(time(0));
+        cout << "\n=== Budgets for " << username << " (" << DateUtils::formatDay(today).substr(0, 7) << ") ===\n";
+        cout << left << setw(20) << "Category" << right << setw(12) << "Spent" << setw(12) << "Budget"
+             << setw(8) << "Used" << setw(12) << "Avg txn" << setw(12) << "Std dev" << "\n";
+        for (const auto& [category, limit] : userBudgets) {
+            RollupCell month = rollups.cellAt(username, "expense", category, RollupStore::Period::MONTH, today);
+            const RunningStats* history = alerts.statsFor(username, category);
+            cout << left << setw(20) << category << right << fixed << setprecision(2)
+                 << setw(12) << month.sum << setw(12) << limit
+                 << setw(7) << setprecision(0) << month.sum * 100.0 / limit << "%" << setprecision(2)
+                 << setw(12) << (history ? history->mean : 0.0)
+                 << setw(12) << (history ? history->stddev() : 0.0) << "\n";
         }
+        printLeftOut(unconvertedFor(username));
     }
     
-    void generateReport(const string& currentUser, UserRole role) {
-        cout << "\n=== Financial Report ===\n";
-        
-        float totalIncome = 0, totalExpense = 0, totalSavings = 0, totalInvestment = 0;
-        int transactionCount = 0;
-        
-        for (const auto& t : transactions) {
-            if (role == UserRole::STANDARD && t.username != currentUser) {
-                continue;
+    // Runs a compaction pass in the foreground, waiting for any background one
+    CompactionReport compactNow() {
+        waitForCompaction();
+        CompactionJob job;
+        {
+            lock_guard<mutex> lock(storeMutex);
+            if (loadFailed) {
+                cerr << "Error: transaction file could not be read at startup; not compacting.\n";
+                return CompactionReport();
             }
-            
-            transactionCount++;
-            if (t.transactionType == "income") totalIncome += t.amount;
-            else if (t.transactionType == "expense") totalExpense += t.amount;
-            else if (t.transactionType == "savings") totalSavings += t.amount;
-            else if (t.transactionType == "investment") totalInvestment += t.amount;
+            job = beginCompaction();
         }
-        
-        cout << "Total Transactions: " << transactionCount << "\n";
-        cout << "Total Income: $" << fixed << setprecision(2) << totalIncome << "\n";
-        cout << "Total Expenses: $" << totalExpense << "\n";
-        cout << "Total Savings: $" << totalSavings << "\n";
-        cout << "Total Investments: $" << totalInvestment << "\n";
-        cout << "Net Worth: $" << (totalIncome - totalExpense + totalSavings + totalInvestment) << "\n";
+        return runCompaction(job);
     }
     
-    void deleteTransaction(const string& id, UserRole role) {
-        if (role != UserRole::ADMIN) {
-            cout << "Access denied. Only administrators can delete transactions.\n";
-            return;
+    void showStorageStatus(bool compact) {
+        if (compact) {
+            CompactionReport report = compactNow();
+            if (report.ok) {
+                cout << "Compaction kept " << report.liveRecords << " records and reclaimed "
+                     << report.reclaimedBytes() << " bytes (" << report.bytesBefore << " -> "
+                     << report.bytesAfter << ") in " << fixed << setprecision(2) << report.millis << " ms.\n";
+            }
         }
         
-        auto it = find_if(transactions.begin(), transactions.end(),
-                         [&id](const Transaction& t) { return t.id == id; });
-        
-        if (it != transactions.end()) {
-            transactionMap.erase(it->id);
-            transactions.erase(it);
-            updateDataStructures();
-            saveTransactions();
-            cout << "Transaction deleted successfully.\n";
-        } else {
-            cout << "Transaction not found.\n";
+        lock_guard<mutex> lock(storeMutex);
+        cout << "\n=== Storage Status ===\n";
+        cout << "Data file: " << fileBytes << " bytes\n";
+        cout << "Live records: " << transactions.size() << " (" << compactBytes() << " bytes compacted)\n";
+        cout << "Space amplification: " << fixed << setprecision(2) << spaceAmplification()
+             << " (compacts at " << compaction.maxAmplification << " above " << compaction.minBytes << " bytes)\n";
+        if (compactionActive) {
+            cout << "Compaction in progress.\n";
+        } else if (lastCompaction.ok) {
+            cout << "Last compaction reclaimed " << lastCompaction.reclaimedBytes() << " bytes.\n";
         }
     }
 };
@@ -823,6 +4446,16 @@ public:
             cout << "9. Delete Transaction (Admin Only)\n";
         }
         
+        cout << "10. Spending by Category over Period\n";
+        cout << "11. Export Transactions\n";
+        
+        if (currentUser.role == UserRole::ADMIN) {
+            cout << "12. Storage Status and Compaction (Admin Only)\n";
+        }
+        
+        cout << "13. Budgets and Alerts\n";
+        cout << "14. Account Balances\n";
+        
         cout << "0. Logout and Exit\n";
         cout << "Enter choice: ";
     }
@@ -848,9 +4481,15 @@ public:
                     case 2:
                         transactionManager.displayAllTransactions(currentUser.username, currentUser.role);
                         break;
-                    case 3:
-                        transactionManager.displayRecentTransactions();
+                    case 3: {
+                        size_t pageSize;
+                        cout << "Transactions per page: ";
+                        if (!(cin >> pageSize) || pageSize == 0) {
+                            throw invalid_argument("Invalid page size");
+                        }
+                        transactionManager.displayRecentTransactions(currentUser.username, currentUser.role, pageSize);
                         break;
+                    }
                     case 4: {
                         string id;
                         cout << "Enter Transaction ID: ";
@@ -879,9 +4518,13 @@ public:
                         transactionManager.showTotalByType(type, currentUser.username, currentUser.role);
                         break;
                     }
-                    case 8:
-                        transactionManager.generateReport(currentUser.username, currentUser.role);
+                    case 8: {
+                        string asOf;
+                        cout << "As of date (YYYY-MM-DD, or '-' for all): ";
+                        cin >> asOf;
+                        transactionManager.generateReport(currentUser.username, currentUser.role, asOf);
                         break;
+                    }
                     case 9:
                         if (currentUser.role == UserRole::ADMIN) {
                             string id;
@@ -892,7 +4535,103 @@ public:
                             cout << "Invalid choice.\n";
                         }
                         break;
+                    case 10: {
+                        string type, from, to, groupBy, username = currentUser.username;
+                        if (currentUser.role == UserRole::ADMIN) {
+                            cout << "Username: ";
+                            cin >> username;
+                        }
+                        cout << "Enter transaction type: ";
+                        cin >> type;
+                        cout << "From date (YYYY-MM-DD): ";
+                        cin >> from;
+                        cout << "To date (YYYY-MM-DD): ";
+                        cin >> to;
+                        cout << "Group by (total/day/month/year): ";
+                        cin >> groupBy;
+                        transactionManager.showRollup(username, type, from, to, groupBy);
+                        break;
+                    }
+                    case 11: {
+                        string format, path, from, to, type, username = currentUser.username;
+                        cout << "Format (csv/jsonl/columnar): ";
+                        cin >> format;
+                        cout << (currentUser.role == UserRole::ADMIN ? "Output file: " : "Output file name: ");
+                        cin >> path;
+                        if (currentUser.role == UserRole::ADMIN) {
+                            cout << "Username (or 'all'): ";
+                            cin >> username;
+                        }
+                        cout << "From date (YYYY-MM-DD or '-'): ";
+                        cin >> from;
+                        cout << "To date (YYYY-MM-DD or '-'): ";
+                        cin >> to;
+                        cout << "Transaction type (or 'all'): ";
+                        cin >> type;
+                        transactionManager.runExport(format, path, username, from, to, type, currentUser.role);
+                        break;
+                    }
+                    case 12:
+                        if (currentUser.role == UserRole::ADMIN) {
+                            string answer;
+                            cout << "Compact the transaction file now? (y/n): ";
+                            cin >> answer;
+                            transactionManager.showStorageStatus(answer == "y" || answer == "Y");
+                        } else {
+                            cout << "Invalid choice.\n";
+                        }
+                        break;
+                    case 13: {
+                        string action, username = currentUser.username;
+                        cout << "1. Set monthly budget\n2. Show budgets\n3. Show recent alerts\n";
+                        cout << "Choose option: ";
+                        cin >> action;
+                        if (action == "3") {
+                            cout << "\n=== Recent Alerts ===\n";
+                            transactionManager.showAlerts(currentUser.username, currentUser.role, cout);
+                            break;
+                        }
+                        if (currentUser.role == UserRole::ADMIN) {
+                            cout << "Username: ";
+                            cin >> username;
+                        }
+                        if (action == "1") {
+                            string category, limitStr;
+                            cout << "Expense category: ";
+                            cin.ignore();
+                            getline(cin, category);
+                            cout << "Monthly limit in " << transactionManager.exchangeRates().baseCurrency()
+                                 << " (0 removes the budget): ";
+                            cin >> limitStr;
+                            if (category.empty() || !SecurityUtils::isValidAmount(limitStr)) {
+                                cout << "Invalid budget.\n";
+                                break;
+                            }
+                            transactionManager.setBudget(username, category, stod(limitStr));
+                            cout << "Budget saved.\n";
+                        } else if (action == "2") {
+                            transactionManager.showBudgets(username);
+                        } else {
+                            cout << "Invalid choice.\n";
+                        }
+                        break;
+                    }
+                    case 14: {
+                        string username = currentUser.username, asOf;
+                        if (currentUser.role == UserRole::ADMIN) {
+                            cout << "Username: ";
+                            cin >> username;
+                        }
+                        cout << "As of date (YYYY-MM-DD, or - for today): ";
+                        cin >> asOf;
+                        transactionManager.showBalances(username, asOf);
+                        break;
+                    }
                     case 0:
+                        // Journaled adds leave the CSV mirror to be refreshed once on exit
+                        transactionManager.saveTransactionsCSV();
+                        transactionManager.persistIndexes();
+                        isLoggedIn = false;
                         cout << "Logging out... Goodbye!\n";
                         break;
                     default:
@@ -909,9 +4648,927 @@ public:
     }
 };
 
+// ------------------------- Batch Mode -------------------------
+// Non-interactive entry points. Credentials come from FINANCE_TRACKER_USER
+// and FINANCE_TRACKER_PASSWORD and must belong to an administrator.
+class BatchMode {
+private:
+    // A token from --login in FINANCE_TRACKER_SESSION skips the password KDF
+    static bool authenticateAdmin(UserManager& users) {
+        if (Config::isSet("FINANCE_TRACKER_SESSION")) {
+            auto [valid, user] = users.authenticateSession(Config::get("FINANCE_TRACKER_SESSION", ""));
+            if (valid && user.role == UserRole::ADMIN) return true;
+            cerr << "FINANCE_TRACKER_SESSION is invalid or expired; run --login again.\n";
+            return false;
+        }
+        auto [success, user] = users.authenticate(Config::get("FINANCE_TRACKER_USER", ""),
+                                                  Config::get("FINANCE_TRACKER_PASSWORD", ""));
+        if (!success || user.role != UserRole::ADMIN) {
+            cerr << "Batch mode requires administrator credentials in FINANCE_TRACKER_USER/FINANCE_TRACKER_PASSWORD.\n";
+            return false;
+        }
+        return true;
+    }
+    
+    // Parses and validates one CSV line in the export layout
+    // (ID,Type,Date,Amount,Description,Category,Username[,Currency[,Account
+    // [,CounterAccount]]]); the ID is reassigned, missing trailing fields
+    // take the base currency and the default account, and transfers must
+    // name their counter account
+    static bool parseRecord(const string& line, vector<string>& fields, IngestRecord& record) {
+        if (!CsvUtils::splitLine(line, fields) || fields.size() < 7) return false;
+        if (!SecurityUtils::isValidTransactionType(fields[1]) ||
+            !SecurityUtils::isValidAmount(fields[3]) ||
+            !SecurityUtils::isValidUsername(fields[6]) ||
+            !Transaction::fitsStoredLimits(fields[4], fields[5]) ||
+            (fields.size() > 7 && !fields[7].empty() && !SecurityUtils::isValidCurrency(fields[7])) ||
+            (fields.size() > 8 && !fields[8].empty() && !SecurityUtils::isValidAccountName(fields[8])) ||
+            !DateUtils::parseDateTime(fields[2], record.date)) {
+            return false;
+        }
+        record.currency = fields.size() > 7 ? move(fields[7]) : string();
+        record.account = fields.size() > 8 ? move(fields[8]) : string();
+        record.counterAccount = fields.size() > 9 ? move(fields[9]) : string();
+        // Transfers need a counter account other than their own, as in
+        // interactive input; other types have none
+        if (fields[1] == "transfer"
+                ? !SecurityUtils::isValidAccountName(record.counterAccount) ||
+                  record.counterAccount == (record.account.empty() ? Transaction::DEFAULT_ACCOUNT : record.account)
+                : !record.counterAccount.empty()) {
+            return false;
+        }
+        record.type = move(fields[1]);
+        record.amount = stof(fields[3]);
+        record.description = move(fields[4]);
+        record.category = move(fields[5]);
+        record.username = move(fields[6]);
+        return true;
+    }
+    
+public:
+    // Feeds a CSV file through the ingestion pipeline using several producer threads
+    static int ingest(const string& path, size_t producers) {
+        UserManager users;
+        if (!authenticateAdmin(users)) return 1;
+        
+        ifstream in(path);
+        if (!in.is_open()) {
+            cerr << "Cannot open " << path << endl;
+            return 1;
+        }
+        vector<string> lines;
+        string line;
+        while (getline(in, line)) {
+            if (line.empty() || line.compare(0, 3, "ID,") == 0) continue;
+            lines.push_back(move(line));
+        }
+        
+        TransactionManager manager;
+        manager.loadTransactions();
+        
+        atomic<size_t> invalid{0};
+        IngestionPipeline pipeline(IngestionSettings::fromConfig(),
+                                   [&manager](vector<IngestRecord>& batch) { manager.applyBatch(batch); });
+        
+        producers = max<size_t>(1, producers);
+        vector<thread> workers;
+        for (size_t p = 0; p < producers; p++) {
+            workers.emplace_back([&, p]() {
+                vector<string> fields;
+                size_t begin = lines.size() * p / producers;
+                size_t end = lines.size() * (p + 1) / producers;
+                for (size_t i = begin; i < end; i++) {
+                    IngestRecord record;
+                    if (parseRecord(lines[i], fields, record)) {
+                        pipeline.submit(move(record));
+                    } else {
+                        invalid.fetch_add(1, memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        pipeline.stop();
+        
+        manager.persistIndexes();
+        manager.saveTransactionsCSV();
+        pipeline.printMetrics(cout);
+        cout << "Rejected " << invalid.load() << " invalid lines.\n";
+        cout << "Alerts raised: " << manager.alertCount() << "\n";
+        if (manager.alertCount() > 0) {
+            manager.showAlerts("", UserRole::ADMIN, cout);
+        }
+        return 0;
+    }
+    
+    // --budget <username> <category> <monthly limit>; a limit of 0 removes it
+    static int setBudget(const string& username, const string& category, const string& limit) {
+        UserManager users;
+        if (!authenticateAdmin(users)) return 1;
+        if (!SecurityUtils::isValidUsername(username) || category.empty() || !SecurityUtils::isValidAmount(limit)) {
+            cerr << "Invalid budget.\n";
+            return 1;
+        }
+        
+        TransactionManager manager;
+        manager.loadTransactions();
+        manager.setBudget(username, category, stod(limit));
+        manager.showBudgets(username);
+        return 0;
+    }
+    
+    // --login: checks FINANCE_TRACKER_USER/FINANCE_TRACKER_PASSWORD once and
+    // prints a session token for FINANCE_TRACKER_SESSION; --logout revokes it
+    static int login() {
+        UserManager users;
+        auto [success, user] = users.authenticate(Config::get("FINANCE_TRACKER_USER", ""),
+                                                  Config::get("FINANCE_TRACKER_PASSWORD", ""));
+        if (!success || user.role != UserRole::ADMIN) {
+            cerr << "Batch mode requires administrator credentials in FINANCE_TRACKER_USER/FINANCE_TRACKER_PASSWORD.\n";
+            return 1;
+        }
+        cout << users.createSession(user) << "\n";
+        return 0;
+    }
+    
+    static int logout() {
+        UserManager users;
+        users.endSession(Config::get("FINANCE_TRACKER_SESSION", ""));
+        return 0;
+    }
+    
+    // --export <format> <file> [username|all] [from|-] [to|-] [type|all]
+    static int exportTo(const string& format, const string& path, const string& username,
+                        const string& from, const string& to, const string& type) {
+        UserManager users;
+        if (!authenticateAdmin(users)) return 1;
+        
+        TransactionManager manager;
+        manager.loadTransactions();
+        return manager.runExport(format, path, username, from, to, type, UserRole::ADMIN) ? 0 : 1;
+    }
+};
+
+// ------------------------- Benchmarks -------------------------
+// Synthetic workloads run with --bench [records]. Nothing is read from or
+// written to the data files.
+class Benchmark {
+private:
+    struct Sample {
+        string type;
+        time_t date;
+        float amount;
+        string description;
+        string category;
+        string username;
+        string currency;  // empty for the base currency
+        string account;
+        string counterAccount;  // credited side of a transfer; empty otherwise
+    };
+    
+    // Field layout of the record store before the arena was introduced
+    struct LegacyTransaction {
+        string id;
+        string transactionType;
+        time_t date;
+        float amount;
+        string description;
+        string category;
+        string username;
+    };
+    
+    struct Measurement {
+        size_t allocations;
+        size_t deallocations;
+        size_t bytes;
+        double millis;
+    };
+    
+    template <typename Fn>
+    static Measurement measure(Fn&& fn) {
+        AllocationStats::reset();
+        auto start = chrono::steady_clock::now();
+        fn();
+        auto end = chrono::steady_clock::now();
+        return {AllocationStats::allocations.load(), AllocationStats::deallocations.load(),
+                AllocationStats::bytes.load(),
+                chrono::duration<double, milli>(end - start).count()};
+    }
+    
+    static vector<Sample> makeSamples(size_t count) {
+        const vector<string> types = {"income", "expense", "savings", "investment", "transfer"};
+        const vector<string> categories = {"Groceries", "Rent", "Salary", "Utilities", "Dining", "Travel"};
+        const vector<string> users = {"alice", "bob", "carol", "dave"};
+        
+        vector<Sample> samples;
+        samples.reserve(count);
+        // Spread evenly over the last ten years
+        const time_t span = 10 * 365 * 86400LL;
+        time_t base = time(0) - span;
+        for (size_t i = 0; i < count; i++) {
+            samples.push_back({types[i % types.size()], base + static_cast<time_t>(span * (i / static_cast<double>(count))),
+                               static_cast<float>((i * 37) % 5000) + 0.99f,
+                               "Synthetic benchmark transaction number " + to_string(i),
+                               categories[(i / 3) % categories.size()], users[i % users.size()], "",
+                               Transaction::DEFAULT_ACCOUNT, ""});
+        }
+        return samples;
+    }
+    
+    // Emplaces every sample into manager
+    static void populate(TransactionManager& manager, const vector<Sample>& samples) {
+        for (const auto& sample : samples) {
+            manager.emplaceTransaction(sample.type, sample.date, sample.amount, sample.description,
+                                       sample.category, sample.username, sample.currency,
+                                       sample.account, sample.counterAccount);
+        }
+    }
+    
+    static void printMeasurement(const string& name, size_t count, const Measurement& m) {
+        cout << left << setw(22) << name << right
+             << fixed << setprecision(2)
+             << setw(10) << m.millis << " ms"
+             << setw(12) << m.allocations << " allocs"
+             << setw(8) << (count ? static_cast<double>(m.allocations) / count : 0.0) << " /rec"
+             << setw(12) << (m.allocations - m.deallocations) << " live blocks"
+             << setw(14) << m.bytes << " bytes\n";
+    }
+    
+    static void benchmarkRecordStore(const vector<Sample>& samples) {
+        cout << "\n--- Record store: build " << samples.size() << " records ---\n";
+        
+        list<LegacyTransaction> transactions;
+        unordered_map<string, LegacyTransaction> transactionMap;
+        map<string, vector<LegacyTransaction>> userTransactions;
+        queue<LegacyTransaction> recentTransactions;
+        Measurement legacy = measure([&]() {
+            size_t counter = 0;
+            for (const auto& sample : samples) {
+                LegacyTransaction t;
+                t.id = "TXN" + to_string(sample.date) + "_" + to_string(++counter);
+                t.transactionType = sample.type;
+                t.date = sample.date;
+                t.amount = sample.amount;
+                t.description = sample.description;
+                t.category = sample.category;
+                t.username = sample.username;
+                
+                transactions.push_back(t);
+                transactionMap[t.id] = t;
+                userTransactions[t.username].push_back(t);
+                recentTransactions.push(t);
+                if (recentTransactions.size() > 10) {
+                    recentTransactions.pop();
+                }
+            }
+        });
+        printMeasurement("legacy (4 copies)", samples.size(), legacy);
+        
+        TransactionManager manager;
+        Measurement arena = measure([&]() { populate(manager, samples); });
+        printMeasurement("arena (in place)", samples.size(), arena);
+        
+        const RecordArena& records = manager.recordArena();
+        double waste = records.reservedBytes()
+            ? 100.0 * (records.reservedBytes() - records.usedBytes()) / records.reservedBytes() : 0.0;
+        cout << "Arena: " << records.slabCount() << " slabs, "
+             << records.usedBytes() << " of " << records.reservedBytes() << " bytes used ("
+             << fixed << setprecision(2) << waste << "% slack)\n";
+    }
+    
+    static void benchmarkRollups(const vector<Sample>& samples) {
+        cout << "\n--- Rollups: monthly expense per category, last 5 years ---\n";
+        TransactionManager manager;
+        populate(manager, samples);
+        
+        int toDay = DateUtils::localDay(time(0));
+        int fromDay = toDay - 5 * 365;
+        const string user = "alice";
+        const string type = "expense";
+        
+        double scanTotal = 0;
+        Measurement scan = measure([&]() {
+            map<pair<string, int>, RollupCell> buckets;
+            for (const auto& sample : samples) {
+                if (sample.username != user || sample.type != type) continue;
+                int day = DateUtils::localDay(sample.date);
+                if (day < fromDay || day > toDay) continue;
+                CivilDate c = DateUtils::civilFromDays(day);
+                RollupCell& cell = buckets[{sample.category, c.year * 12 + c.month - 1}];
+                cell.sum += sample.amount;
+                cell.count++;
+            }
+            for (const auto& entry : buckets) scanTotal += entry.second.sum;
+        });
+        printMeasurement("full scan", samples.size(), scan);
+        
+        double rollupTotal = 0;
+        const RollupStore& rollups = manager.rollupStore();
+        Measurement query = measure([&]() {
+            for (const auto& entry : rollups.totalsByCategory(user, type, fromDay, toDay)) {
+                for (const auto& bucket : rollups.periodSeries(user, type, entry.first,
+                                                               RollupStore::Period::MONTH, fromDay, toDay)) {
+                    rollupTotal += bucket.second.sum;
+                }
+            }
+        });
+        printMeasurement("rollup query", samples.size(), query);
+        cout << "Totals: scan $" << fixed << setprecision(2) << scanTotal
+             << ", rollup $" << rollupTotal << "\n";
+    }
+    
+    // Record layout of the original per-field XOR codec
+    static void writeLegacyRecord(ostream& os, const Transaction& t) {
+        auto writeField = [&os](string_view field, bool obfuscate) {
+            string copy(field);
+            if (obfuscate) SecurityUtils::xorInPlace(&copy[0], copy.size());
+            size_t len = copy.length();
+            os.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            os.write(copy.c_str(), len);
+        };
+        writeField(t.id, false);
+        writeField(t.transactionType, false);
+        os.write(reinterpret_cast<const char*>(&t.date), sizeof(t.date));
+        os.write(reinterpret_cast<const char*>(&t.amount), sizeof(t.amount));
+        writeField(t.description, true);
+        writeField(t.category, true);
+        writeField(t.username, false);
+    }
+    
+    static void printThroughput(const string& name, size_t bytes, const Measurement& m) {
+        cout << left << setw(22) << name << right << fixed << setprecision(2)
+             << setw(10) << m.millis << " ms"
+             << setw(10) << (m.millis > 0 ? bytes / 1048576.0 / (m.millis / 1000.0) : 0.0) << " MiB/s"
+             << setw(12) << m.allocations << " allocs\n";
+    }
+    
+    static void benchmarkCodec(const vector<Sample>& samples) {
+        cout << "\n--- Record codec: " << samples.size() << " records ---\n";
+        TransactionManager source;
+        populate(source, samples);
+        
+        ostringstream legacyOut;
+        Measurement legacyWrite = measure([&]() {
+            for (const auto& t : source.allTransactions()) {
+                writeLegacyRecord(legacyOut, t);
+            }
+        });
+        string legacyBytes = legacyOut.str();
+        printThroughput("legacy XOR encode", legacyBytes.size(), legacyWrite);
+        
+        ostringstream segmentOut;
+        Measurement segmentWrite = measure([&]() {
+            source.writeStore(segmentOut);
+        });
+        string segmentBytes = segmentOut.str();
+        printThroughput("segment encode", segmentBytes.size(), segmentWrite);
+        
+        TransactionManager legacyTarget;
+        istringstream legacyIn(legacyBytes);
+        Measurement legacyRead = measure([&]() {
+            legacyTarget.readStore(legacyIn);
+        });
+        printThroughput("legacy XOR decode", legacyBytes.size(), legacyRead);
+        
+        TransactionManager segmentTarget;
+        istringstream segmentIn(segmentBytes);
+        Measurement segmentRead = measure([&]() {
+            segmentTarget.readStore(segmentIn);
+        });
+        printThroughput("segment decode", segmentBytes.size(), segmentRead);
+    }
+    
+    static void benchmarkPasswordHashing() {
+        cout << "\n--- Password hashing (single core) ---\n";
+        const string password = "correct horse battery staple";
+        for (unsigned int iterations : {10000u, 100000u, SecurityUtils::kdfIterations()}) {
+            const int rounds = 5;
+            Measurement m = measure([&]() {
+                for (int i = 0; i < rounds; i++) {
+                    SecurityUtils::hashPassword(password, iterations);
+                }
+            });
+            cout << left << setw(22) << ("pbkdf2 " + to_string(iterations)) << right << fixed << setprecision(2)
+                 << setw(10) << m.millis / rounds << " ms/hash"
+                 << setw(10) << (m.millis > 0 ? rounds * 1000.0 / m.millis : 0.0) << " hashes/s\n";
+        }
+        
+        SessionCache sessions;
+        string token = sessions.issue("alice");
+        const int lookups = 1000000;
+        string username;
+        Measurement cached = measure([&]() {
+            for (int i = 0; i < lookups; i++) {
+                sessions.validate(token, username);
+            }
+        });
+        cout << left << setw(22) << "session validate" << right << fixed << setprecision(2)
+             << setw(10) << cached.millis * 1000000.0 / lookups << " ns/op\n";
+    }
+    
+    static void benchmarkIngestion(const vector<Sample>& samples) {
+        const size_t producers = 4;
+        cout << "\n--- Ingestion: " << samples.size() << " records, " << producers << " producers ---\n";
+        const string prefix = "bench_";
+        {
+            TransactionManager manager(prefix);
+            IngestionPipeline pipeline(IngestionSettings::fromConfig(),
+                                       [&manager](vector<IngestRecord>& batch) { manager.applyBatch(batch); });
+            vector<thread> workers;
+            for (size_t p = 0; p < producers; p++) {
+                workers.emplace_back([&, p]() {
+                    for (size_t i = p; i < samples.size(); i += producers) {
+                        const Sample& sample = samples[i];
+                        pipeline.submit({sample.type, sample.date, sample.amount,
+                                         sample.description, sample.category, sample.username, "", "", ""});
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            pipeline.stop();
+            pipeline.printMetrics(cout);
+        }
+        remove((prefix + "transactions.dat").c_str());
+    }
+    
+    static void benchmarkExport(const vector<Sample>& samples) {
+        cout << "\n--- Export: " << samples.size() << " records ---\n";
+        TransactionManager manager;
+        populate(manager, samples);
+        
+        const string path = "bench_export.out";
+        for (const char* name : {"csv", "jsonl", "columnar"}) {
+            ExportFormat format = ExportFormat::CSV;
+            RecordFormatter::parseFormat(name, format);
+            size_t rows = 0;
+            Measurement m = measure([&]() {
+                manager.exportTransactions(ExportFilter(), format, path, rows);
+            });
+            ifstream written(path, ios::binary | ios::ate);
+            size_t bytes = static_cast<size_t>(written.tellg());
+            cout << left << setw(22) << ("export " + string(name)) << right << fixed << setprecision(2)
+                 << setw(10) << m.millis << " ms"
+                 << setw(14) << setprecision(0) << (m.millis > 0 ? rows / (m.millis / 1000.0) : 0.0) << " rows/s"
+                 << setw(10) << setprecision(2) << bytes / 1048576.0 << " MiB\n";
+        }
+        remove(path.c_str());
+    }
+    
+    static void benchmarkAlerts(const vector<Sample>& samples) {
+        cout << "\n--- Alert rules: " << samples.size() << " inserts ---\n";
+        const string prefix = "bench_";
+        {
+            TransactionManager manager(prefix);
+            for (const char* user : {"alice", "bob", "carol", "dave"}) {
+                for (const char* category : {"Groceries", "Rent", "Utilities", "Dining", "Travel"}) {
+                    manager.setBudget(user, category, 20000);
+                }
+            }
+            Measurement inserts = measure([&]() { populate(manager, samples); });
+            
+            // What one insert would cost if the month's spending were rescanned
+            const Sample& last = samples.back();
+            CivilDate month = DateUtils::civilFromDays(DateUtils::localDay(last.date));
+            double spent = 0;
+            Measurement rescan = measure([&]() {
+                for (const auto& t : manager.allTransactions()) {
+                    if (t.username != last.username || t.category != last.category ||
+                        t.transactionType != "expense") {
+                        continue;
+                    }
+                    CivilDate c = DateUtils::civilFromDays(DateUtils::localDay(t.date));
+                    if (c.year == month.year && c.month == month.month) {
+                        spent += t.amount;
+                    }
+                }
+            });
+            
+            cout << left << setw(22) << "insert + rules" << right << fixed << setprecision(2)
+                 << setw(10) << inserts.millis * 1000000.0 / max<size_t>(1, samples.size()) << " ns/insert"
+                 << setw(10) << manager.alertCount() << " alerts\n";
+            cout << left << setw(22) << "rescan per insert" << right
+                 << setw(10) << rescan.millis * 1000000.0 << " ns/insert\n";
+        }
+        remove((prefix + "budgets.dat").c_str());
+    }
+    
+    // Reports on snapshots while a writer keeps adding and deleting records
+    static void benchmarkSnapshots(const vector<Sample>& samples) {
+        cout << "\n--- Snapshot reports under concurrent writes: " << samples.size() << " records ---\n";
+        const string prefix = "bench_";
+        {
+            TransactionManager manager(prefix);
+            populate(manager, samples);
+            vector<string> victims;
+            for (const auto& t : manager.allTransactions()) {
+                if (victims.size() == samples.size() / 2) break;
+                victims.emplace_back(t.id);
+            }
+            
+            atomic<bool> stop{false};
+            atomic<size_t> commits{0};
+            thread writer([&]() {
+                vector<IngestRecord> batch;
+                for (size_t i = 0; !stop.load(memory_order_relaxed); i++) {
+                    const Sample& sample = samples[i % samples.size()];
+                    batch.assign(16, {sample.type, sample.date, sample.amount,
+                                      sample.description, sample.category, sample.username, "", "", ""});
+                    manager.applyBatch(batch);
+                    if (i < victims.size()) manager.removeTransaction(victims[i]);
+                    commits.fetch_add(2, memory_order_relaxed);
+                }
+            });
+            
+            const int reports = 20;
+            bool consistent = true;
+            Measurement reads = measure([&]() {
+                for (int i = 0; i < reports; i++) {
+                    Ledger::Snapshot snapshot = manager.snapshot();
+                    auto first = manager.reportTotals(snapshot, "", UserRole::ADMIN, numeric_limits<time_t>::max());
+                    auto second = manager.reportTotals(snapshot, "", UserRole::ADMIN, numeric_limits<time_t>::max());
+                    consistent = consistent && first.count == second.count && first.netWorth() == second.netWorth();
+                }
+            });
+            stop.store(true);
+            writer.join();
+            
+            cout << left << setw(22) << "snapshot report" << right << fixed << setprecision(2)
+                 << setw(10) << reads.millis / (2 * reports) << " ms/scan"
+                 << setw(12) << setprecision(0) << commits.load() / (reads.millis / 1000.0) << " commits/s alongside"
+                 << (consistent ? "  (repeatable)" : "  (INCONSISTENT)") << "\n";
+        }
+        for (const char* name : {"transactions.dat", "rollups.dat"}) {
+            remove((prefix + name).c_str());
+        }
+    }
+    
+    // Reports over records in several currencies: column batches against the
+    // dense rate table, versus a per-row lookup in the dated rate maps
+    static void benchmarkCurrencies(const vector<Sample>& samples) {
+        cout << "\n--- Multi-currency reports: " << samples.size() << " records ---\n";
+        const vector<string> currencies = {"USD", "EUR", "GBP", "JPY", "INR", "CAD"};
+        
+        // Daily rates over the samples' ten years, as a rates file would give
+        ExchangeRates::DatedRates dated;
+        int firstDay = DateUtils::localDay(samples.front().date);
+        int lastDay = DateUtils::localDay(samples.back().date);
+        for (size_t c = 1; c < currencies.size(); c++) {
+            for (int day = firstDay; day <= lastDay; day++) {
+                dated[currencies[c]][day] = 0.5 + c * 0.25 + 0.01 * ((day * 7 + c) % 13);
+            }
+        }
+        
+        vector<Sample> mixed = samples;
+        for (size_t i = 0; i < mixed.size(); i++) {
+            mixed[i].currency = currencies[i % currencies.size()];
+        }
+        
+        TransactionManager single, multi;
+        multi.useExchangeRates(dated);
+        populate(single, samples);
+        populate(multi, mixed);
+        
+        const int reports = 20;
+        const time_t everything = numeric_limits<time_t>::max();
+        double singleNet = 0, batchedNet = 0, naiveNet = 0;
+        Measurement singleReport = measure([&]() {
+            for (int i = 0; i < reports; i++) {
+                singleNet = single.reportTotals(single.snapshot(), "", UserRole::ADMIN, everything).netWorth();
+            }
+        });
+        Measurement batched = measure([&]() {
+            for (int i = 0; i < reports; i++) {
+                batchedNet = multi.reportTotals(multi.snapshot(), "", UserRole::ADMIN, everything).netWorth();
+            }
+        });
+        Measurement naive = measure([&]() {
+            for (int i = 0; i < reports; i++) {
+                naiveNet = 0;
+                multi.snapshot().forEach([&](const Transaction& t) {
+                    double rate = 1.0;
+                    auto it = dated.find(string(t.currency));
+                    if (it != dated.end()) {
+                        auto at = it->second.upper_bound(DateUtils::localDay(t.date));
+                        rate = at == it->second.begin() ? at->second : prev(at)->second;
+                    }
+                    double value = t.amount * rate;
+                    if (t.transactionType == "expense") naiveNet -= value;
+                    else if (t.transactionType != "transfer") naiveNet += value;
+                });
+            }
+        });
+        
+        cout << left << setw(22) << "single currency" << right << fixed << setprecision(2)
+             << setw(10) << singleReport.millis / reports << " ms/report\n";
+        cout << left << setw(22) << "batched conversion" << right
+             << setw(10) << batched.millis / reports << " ms/report\n";
+        cout << left << setw(22) << "per-row map lookup" << right
+             << setw(10) << naive.millis / reports << " ms/report"
+             << "  (net " << setprecision(0) << batchedNet << " batched, " << naiveNet << " per-row, "
+             << singleNet << " before conversion)\n";
+    }
+    
+    // Balance of one account as of random days: a prefix query on the
+    // account's running totals versus scanning and posting every record
+    static void benchmarkBalances(const vector<Sample>& samples) {
+        cout << "\n--- Account balances: " << samples.size() << " records ---\n";
+        const vector<string> accounts = {"checking", "savings", "brokerage"};
+        
+        vector<Sample> posted = samples;
+        for (size_t i = 0; i < posted.size(); i++) {
+            posted[i].account = accounts[i % accounts.size()];
+            if (posted[i].type == "transfer") posted[i].counterAccount = accounts[(i + 1) % accounts.size()];
+        }
+        
+        TransactionManager manager;
+        Measurement inserts = measure([&]() { populate(manager, posted); });
+        
+        const int queries = 1000;
+        const string user = samples.front().username;
+        int firstDay = DateUtils::localDay(samples.front().date);
+        int lastDay = DateUtils::localDay(samples.back().date);
+        mt19937 rng(42);
+        vector<int> days(queries);
+        for (int& day : days) day = firstDay + static_cast<int>(rng() % (lastDay - firstDay + 1));
+        
+        double scanned = 0;
+        Measurement lookups = measure([&]() {
+            for (int day : days) manager.accountBalance(user, "checking", day);
+        });
+        const int scans = 20;
+        Measurement scan = measure([&]() {
+            for (int q = 0; q < scans; q++) {
+                int day = days[q];
+                double balance = 0;
+                manager.snapshot().forEach([&](const Transaction& t) {
+                    if (t.username != user || DateUtils::localDay(t.date) > day) return;
+                    double value = t.amount;
+                    if (t.transactionType == "transfer") {
+                        if (t.account == "checking") balance -= value;
+                        if (t.counterAccount == "checking") balance += value;
+                    } else if (t.account == "checking") {
+                        balance += t.transactionType == "expense" ? -value : value;
+                    }
+                });
+                scanned += balance;
+            }
+        });
+        double check = 0;
+        for (int q = 0; q < scans; q++) check += manager.accountBalance(user, "checking", days[q]);
+        
+        cout << left << setw(22) << "insert + postings" << right << fixed << setprecision(2)
+             << setw(10) << inserts.millis * 1000000.0 / max<size_t>(1, samples.size()) << " ns/insert\n";
+        cout << left << setw(22) << "balance as of day" << right
+             << setw(10) << lookups.millis * 1000000.0 / queries << " ns/query\n";
+        cout << left << setw(22) << "full scan" << right
+             << setw(10) << scan.millis * 1000000.0 / scans << " ns/query"
+             << (fabs(check - scanned) < 0.01 * max(1.0, fabs(scanned)) ? "  (balances agree)" : "  (MISMATCH)")
+             << "\n";
+    }
+    
+    static void benchmarkCompaction(const vector<Sample>& samples) {
+        cout << "\n--- Deletes and compaction: " << samples.size() << " records ---\n";
+        const string prefix = "bench_";
+        {
+            TransactionManager manager(prefix);
+            populate(manager, samples);
+            Measurement rewrite = measure([&]() { manager.saveTransactions(); });
+            
+            // Delete every step-th record, 2000 in all
+            vector<string> victims;
+            const size_t step = max<size_t>(1, samples.size() / 2000);
+            size_t position = 0;
+            for (const auto& t : manager.allTransactions()) {
+                if (position++ % step == 0 && victims.size() < 2000) {
+                    victims.emplace_back(t.id);
+                }
+            }
+            Measurement deletes = measure([&]() {
+                for (const auto& id : victims) {
+                    manager.removeTransaction(id);
+                }
+            });
+            CompactionReport report = manager.compactNow();
+            
+            cout << left << setw(22) << "full rewrite" << right << fixed << setprecision(2)
+                 << setw(10) << rewrite.millis << " ms/delete (previous behaviour)\n";
+            cout << left << setw(22) << "tombstone delete" << right
+                 << setw(10) << (victims.empty() ? 0.0 : deletes.millis / victims.size()) << " ms/delete\n";
+            cout << left << setw(22) << "compaction" << right
+                 << setw(10) << report.millis << " ms, reclaimed " << report.reclaimedBytes() << " bytes ("
+                 << report.bytesBefore << " -> " << report.bytesAfter << ")\n";
+        }
+        for (const char* name : {"transactions.dat", "transactions.csv", "rollups.dat"}) {
+            remove((prefix + name).c_str());
+        }
+    }
+    
+public:
+    static void run(size_t count) {
+        cout << "=== Personal Finance Tracker Benchmarks ===\n";
+        if (!AllocationStats::enabled) {
+            cout << "(allocation counts read 0; rebuild with -DPFT_COUNT_ALLOCATIONS to record them)\n";
+        }
+        benchmarkPasswordHashing();
+        vector<Sample> samples = makeSamples(count);
+        benchmarkRecordStore(samples);
+        benchmarkRollups(samples);
+        benchmarkCodec(samples);
+        benchmarkIngestion(samples);
+        benchmarkExport(samples);
+        benchmarkCompaction(samples);
+        benchmarkAlerts(samples);
+        benchmarkSnapshots(samples);
+        benchmarkCurrencies(samples);
+        benchmarkBalances(samples);
+    }
+};
+
+// ------------------------- Self Test -------------------------
+// Known-answer tests for the built-in crypto, run with --selftest:
+// SHA-256 (FIPS 180-4), HMAC-SHA256 (RFC 4231), PBKDF2-HMAC-SHA256 (the
+// RFC 6070 inputs with their published SHA-256 outputs) and ChaCha20,
+// Poly1305 and the AEAD construction (RFC 8439).
+class SelfTest {
+private:
+    int failures = 0;
+    
+    static vector<uint8_t> bytes(const string& hex) {
+        vector<uint8_t> out;
+        SecurityUtils::fromHex(hex, out);
+        return out;
+    }
+    
+    static vector<uint8_t> sequence(uint8_t first, size_t count) {
+        vector<uint8_t> out(count);
+        for (size_t i = 0; i < count; i++) out[i] = uint8_t(first + i);
+        return out;
+    }
+    
+    void check(const string& name, const uint8_t* actual, size_t len, const string& expected) {
+        bool passed = SecurityUtils::toHex(actual, len) == expected;
+        if (!passed) failures++;
+        cout << (passed ? "PASS  " : "FAIL  ") << name << "\n";
+    }
+    
+    void sha256(const string& name, const string& message, const string& expected) {
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        Sha256 hash;
+        hash.update(message.data(), message.size());
+        hash.finish(digest);
+        check(name, digest, sizeof(digest), expected);
+    }
+    
+    void hmac(const string& name, const vector<uint8_t>& key, const string& message, const string& expected) {
+        uint8_t mac[Sha256::DIGEST_SIZE];
+        HmacSha256 keyed(key.data(), key.size());
+        keyed.update(message.data(), message.size());
+        keyed.finish(mac);
+        check(name, mac, sizeof(mac), expected);
+    }
+    
+    void pbkdf2(const string& name, const string& password, const string& salt, unsigned int iterations,
+                const string& expected) {
+        uint8_t derived[Sha256::DIGEST_SIZE];
+        SecurityUtils::pbkdf2(password, reinterpret_cast<const uint8_t*>(salt.data()), salt.size(),
+                              iterations, derived);
+        check(name, derived, sizeof(derived), expected);
+    }
+    
+    void testSha256() {
+        sha256("SHA-256 \"abc\"", "abc",
+               "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        sha256("SHA-256 empty message", "",
+               "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        sha256("SHA-256 448-bit message", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+               "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        
+        // One million 'a', fed in uneven pieces to cover the buffering path
+        const string chunk(999, 'a');
+        Sha256 hash;
+        size_t fed = 0;
+        while (fed < 1000000) {
+            size_t take = min(chunk.size(), 1000000 - fed);
+            hash.update(chunk.data(), take);
+            fed += take;
+        }
+        uint8_t digest[Sha256::DIGEST_SIZE];
+        hash.finish(digest);
+        check("SHA-256 one million 'a'", digest, sizeof(digest),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+    
+    void testHmac() {
+        hmac("HMAC-SHA256 RFC 4231 case 1", vector<uint8_t>(20, 0x0b), "Hi There",
+             "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+        hmac("HMAC-SHA256 RFC 4231 case 2", {'J', 'e', 'f', 'e'}, "what do ya want for nothing?",
+             "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+        hmac("HMAC-SHA256 RFC 4231 case 3", vector<uint8_t>(20, 0xaa), string(50, '\xdd'),
+             "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+        hmac("HMAC-SHA256 RFC 4231 case 6", vector<uint8_t>(131, 0xaa),
+             "Test Using Larger Than Block-Size Key - Hash Key First",
+             "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+        hmac("HMAC-SHA256 RFC 4231 case 7", vector<uint8_t>(131, 0xaa),
+             "This is a test using a larger than block-size key and a larger than block-size data. "
+             "The key needs to be hashed before being used by the HMAC algorithm.",
+             "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2");
+    }
+    
+    void testPbkdf2() {
+        pbkdf2("PBKDF2-HMAC-SHA256 c=1", "password", "salt", 1,
+               "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+        pbkdf2("PBKDF2-HMAC-SHA256 c=2", "password", "salt", 2,
+               "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43");
+        pbkdf2("PBKDF2-HMAC-SHA256 c=4096", "password", "salt", 4096,
+               "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+    }
+    
+    void testChaCha20Poly1305() {
+        const string sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+                                 "for the future, sunscreen would be it.";
+        
+        // RFC 8439 section 2.4.2
+        vector<uint8_t> key = sequence(0x00, ChaCha20::KEY_SIZE);
+        vector<uint8_t> nonce = bytes("000000000000004a00000000");
+        vector<uint8_t> data(sunscreen.begin(), sunscreen.end());
+        ChaCha20(key.data(), nonce.data(), 1).apply(data.data(), data.size());
+        check("ChaCha20 RFC 8439 2.4.2", data.data(), data.size(),
+              "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+              "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+              "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+              "5af90bbf74a35be6b40b8eedf2785e42874d");
+        
+        // RFC 8439 section 2.5.2
+        vector<uint8_t> polyKey = bytes("85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+        const string forum = "Cryptographic Forum Research Group";
+        uint8_t tag[Poly1305::TAG_SIZE];
+        Poly1305 mac(polyKey.data());
+        mac.update(forum.data(), forum.size());
+        mac.finish(tag);
+        check("Poly1305 RFC 8439 2.5.2", tag, sizeof(tag), "a8061dc1305136c6c22b8baf0c0127a9");
+        
+        // RFC 8439 section 2.8.2
+        key = sequence(0x80, ChaCha20::KEY_SIZE);
+        nonce = bytes("070000004041424344454647");
+        vector<uint8_t> aad = bytes("50515253c0c1c2c3c4c5c6c7");
+        data.assign(sunscreen.begin(), sunscreen.end());
+        SegmentCipher::seal(key.data(), nonce.data(), aad.data(), aad.size(), data.data(), data.size(), tag);
+        check("ChaCha20-Poly1305 RFC 8439 2.8.2 ciphertext", data.data(), data.size(),
+              "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+              "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+              "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+              "3ff4def08e4b7a9de576d26586cec64b6116");
+        check("ChaCha20-Poly1305 RFC 8439 2.8.2 tag", tag, sizeof(tag), "1ae10b594f09e26a7e902ecbd0600691");
+    }
+    
+public:
+    // Returns the number of failed vectors
+    static int run() {
+        cout << "=== Personal Finance Tracker Self Test ===\n";
+        SelfTest test;
+        test.testSha256();
+        test.testHmac();
+        test.testPbkdf2();
+        test.testChaCha20Poly1305();
+        cout << (test.failures == 0 ? "All known-answer tests passed.\n"
+                                    : to_string(test.failures) + " known-answer test(s) failed.\n");
+        return test.failures;
+    }
+};
+
 // ------------------------- Main Function -------------------------
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        if (argc > 1 && string(argv[1]) == "--bench") {
+            size_t count = argc > 2 ? stoul(argv[2]) : 100000;
+            Benchmark::run(count);
+            return 0;
+        }
+        if (argc > 1 && string(argv[1]) == "--selftest") {
+            return SelfTest::run() == 0 ? 0 : 1;
+        }
+        if (argc > 1 && string(argv[1]) == "--login") {
+            return BatchMode::login();
+        }
+        if (argc > 1 && string(argv[1]) == "--logout") {
+            return BatchMode::logout();
+        }
+        if (argc > 3 && string(argv[1]) == "--export") {
+            return BatchMode::exportTo(argv[2], argv[3], argc > 4 ? argv[4] : "all", argc > 5 ? argv[5] : "-",
+                                       argc > 6 ? argv[6] : "-", argc > 7 ? argv[7] : "all");
+        }
+        if (argc > 4 && string(argv[1]) == "--budget") {
+            return BatchMode::setBudget(argv[2], argv[3], argv[4]);
+        }
+        if (argc > 2 && string(argv[1]) == "--ingest") {
+            size_t producers = argc > 3 ? stoul(argv[3]) : 4;
+            return BatchMode::ingest(argv[2], producers);
+        }
+        
         cout << "=== Personal Finance Tracker===\n";
         cout << "Created by: Sumanth\n";
         cout << "Features: Secure Authentication, File Handling, Advanced Data Structures\n\n";